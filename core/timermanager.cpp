@@ -23,136 +23,416 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <loguru.hpp>
 #include "timermanager.h"
+#include <utils/profiler.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cinttypes>
-#include <memory>
-#include <mutex>
+#include <thread>
+#include <utility>
 
 TimerManager* TimerManager::timer_manager;
 
-uint32_t TimerManager::add_oneshot_timer(uint64_t timeout, timer_cb cb)
+#ifdef TIMER_PROFILING
+static const char* hist_bucket_names[TIMER_HIST_BUCKETS] = {
+    "< 1 us", "< 10 us", "< 100 us", "< 1 ms", "< 10 ms", ">= 10 ms"
+};
+
+static inline int hist_bucket(uint64_t ns) {
+    int bucket = 0;
+
+    for (uint64_t limit = 1000; bucket < TIMER_HIST_BUCKETS - 1 && ns >= limit; limit *= 10)
+        bucket++;
+
+    return bucket;
+}
+
+class TimerProfile : public BaseProfile {
+public:
+    TimerProfile() : BaseProfile("Timers") {};
+
+    void populate_variables(std::vector<ProfileVar>& vars) {
+        vars.clear();
+
+        std::vector<std::pair<std::string, TimerStats>> labels(
+            TimerManager::get_instance()->get_timer_stats().begin(),
+            TimerManager::get_instance()->get_timer_stats().end());
+
+        // timers eating most host time first
+        std::sort(labels.begin(), labels.end(), [](const auto& a, const auto& b) {
+            return a.second.host_ns > b.second.host_ns;
+        });
+
+        uint64_t total_ns = 0;
+        for (auto& [label, stats] : labels)
+            total_ns += stats.host_ns;
+        total_ns = std::max(total_ns, (uint64_t)1);
+
+        for (auto& [label, stats] : labels) {
+            if (!stats.calls)
+                continue;
+
+            vars.push_back({.name = label + ": calls",
+                            .format = ProfileVarFmt::DEC,
+                            .value = stats.calls});
+            vars.push_back({.name = label + ": host ns",
+                            .format = ProfileVarFmt::COUNT,
+                            .value = stats.host_ns,
+                            .count_total = total_ns});
+            vars.push_back({.name = label + ": host ns max",
+                            .format = ProfileVarFmt::DEC,
+                            .value = stats.host_max_ns});
+            vars.push_back({.name = label + ": late ns max",
+                            .format = ProfileVarFmt::DEC,
+                            .value = stats.late_max_ns});
+
+            for (int i = 0; i < TIMER_HIST_BUCKETS; i++) {
+                if (stats.host_hist[i])
+                    vars.push_back({.name = label + ": host " + hist_bucket_names[i],
+                                    .format = ProfileVarFmt::COUNT,
+                                    .value = stats.host_hist[i],
+                                    .count_total = stats.calls});
+            }
+            for (int i = 0; i < TIMER_HIST_BUCKETS; i++) {
+                if (stats.late_hist[i])
+                    vars.push_back({.name = label + ": late " + hist_bucket_names[i],
+                                    .format = ProfileVarFmt::COUNT,
+                                    .value = stats.late_hist[i],
+                                    .count_total = stats.calls});
+            }
+        }
+    };
+
+    void reset() {
+        TimerManager::get_instance()->reset_timer_stats();
+    };
+};
+
+void TimerManager::register_profile()
+{
+    if (gProfilerObj)
+        gProfilerObj->register_profile("Timers",
+            std::unique_ptr<BaseProfile>(new TimerProfile()));
+}
+
+void TimerManager::reset_timer_stats()
 {
-    TimerInfo* ti = new TimerInfo;
+    // entries stay, timers refer to them
+    for (auto& entry : this->timer_stats)
+        entry.second = {};
+}
 
-    ti->id          = ++this->id;
-    ti->timeout_ns  = this->get_time_now() + timeout;
-    ti->interval_ns = 0;
-    ti->cb          = cb;
+TimerStats* TimerManager::get_stats(const char* label)
+{
+    auto it = this->label_stats.find(label);
+    if (it != this->label_stats.end())
+        return it->second;
 
-    std::shared_ptr<TimerInfo> timer_desc(ti);
+    // labels with the same text share their statistics
+    TimerStats* stats = &this->timer_stats[label ? label : "unlabeled"];
+    this->label_stats[label] = stats;
 
-    // add new timer to the timer queue
-    this->timer_queue.push(timer_desc);
+    return stats;
+}
+#endif
 
-    // notify listeners about changes in the timer queue
-    if (!this->cb_active) {
-        this->notify_timer_changes();
+uint32_t TimerManager::alloc_slot()
+{
+    uint32_t slot_idx = this->free_head;
+
+    if (slot_idx != TIMER_NO_SLOT) {
+        this->free_head = this->timer_slots[slot_idx].next_free;
+    } else {
+        slot_idx = (uint32_t)this->timer_slots.size();
+        if (slot_idx >= (1UL << TIMER_SLOT_BITS) - 1) {
+            ABORT_F("TimerManager: too many timers");
+        }
+        this->timer_slots.emplace_back();
     }
 
-    return ti->id;
+    TimerInfo& ti = this->timer_slots[slot_idx];
+    ti.gen++;
+    ti.id       = (ti.gen << TIMER_SLOT_BITS) | (slot_idx + 1);
+    ti.heap_pos = TIMER_NOT_QUEUED;
+
+    return slot_idx;
 }
 
-uint32_t TimerManager::add_immediate_timer(timer_cb cb) {
-    TimerInfo* ti = new TimerInfo;
+void TimerManager::free_slot(uint32_t slot_idx)
+{
+    TimerInfo& ti = this->timer_slots[slot_idx];
 
-    ti->id          = ++this->id;
-    ti->timeout_ns  = this->get_time_now();
-    ti->interval_ns = 0;
-    ti->cb          = cb;
+    ti.id           = 0;
+    ti.cb           = nullptr; // release whatever the callback captured
+    ti.next_free    = this->free_head;
+    this->free_head = slot_idx;
+}
 
-    std::shared_ptr<TimerInfo> timer_desc(ti);
+// Place entry at pos or above it, pos must be a hole.
+void TimerManager::sift_up(uint32_t pos, TimerHeapEntry entry)
+{
+    while (pos) {
+        uint32_t parent = (pos - 1) >> 1;
+        if (this->timer_heap[parent].timeout_ns <= entry.timeout_ns)
+            break;
+        this->timer_heap[pos] = this->timer_heap[parent];
+        this->timer_slots[this->timer_heap[pos].slot_idx].heap_pos = pos;
+        pos = parent;
+    }
 
-    // add new timer to the timer queue
-    this->timer_queue.push(timer_desc);
+    this->timer_heap[pos] = entry;
+    this->timer_slots[entry.slot_idx].heap_pos = pos;
+}
 
-    // notify listeners about changes in the timer queue
-    if (!this->cb_active) {
-        this->notify_timer_changes();
+// Place entry at pos or below it, pos must be a hole.
+void TimerManager::sift_down(uint32_t pos, TimerHeapEntry entry)
+{
+    uint32_t count = (uint32_t)this->timer_heap.size();
+
+    while (true) {
+        uint32_t child = (pos << 1) + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count &&
+            this->timer_heap[child + 1].timeout_ns < this->timer_heap[child].timeout_ns)
+            child++;
+        if (entry.timeout_ns <= this->timer_heap[child].timeout_ns)
+            break;
+        this->timer_heap[pos] = this->timer_heap[child];
+        this->timer_slots[this->timer_heap[pos].slot_idx].heap_pos = pos;
+        pos = child;
     }
 
-    return ti->id;
+    this->timer_heap[pos] = entry;
+    this->timer_slots[entry.slot_idx].heap_pos = pos;
 }
 
-uint32_t TimerManager::add_cyclic_timer(uint64_t interval, uint64_t delay, timer_cb cb)
+void TimerManager::heap_push(uint32_t slot_idx, uint64_t timeout_ns)
 {
-    TimerInfo* ti = new TimerInfo;
+    this->timer_heap.emplace_back();
+    this->sift_up((uint32_t)this->timer_heap.size() - 1, {timeout_ns, slot_idx});
+}
 
-    ti->id          = ++this->id;
-    ti->timeout_ns  = this->get_time_now() + delay;
-    ti->interval_ns = interval;
-    ti->cb          = cb;
+void TimerManager::heap_remove(uint32_t pos)
+{
+    TimerHeapEntry last = this->timer_heap.back();
 
-    std::shared_ptr<TimerInfo> timer_desc(ti);
+    this->timer_slots[this->timer_heap[pos].slot_idx].heap_pos = TIMER_NOT_QUEUED;
+    this->timer_heap.pop_back();
+
+    if (pos == this->timer_heap.size())
+        return; // removed the last element
+
+    // move the last element into the hole and restore heap order
+    if (pos && this->timer_heap[(pos - 1) >> 1].timeout_ns > last.timeout_ns)
+        this->sift_up(pos, last);
+    else
+        this->sift_down(pos, last);
+}
+
+// Latest expiry up to limit in the subheap at pos.
+uint64_t TimerManager::coalesced_timeout(uint32_t pos, uint64_t limit)
+{
+    uint64_t timeout = this->timer_heap[pos].timeout_ns;
+    uint32_t child   = (pos << 1) + 1;
+
+    for (uint32_t end = std::min(child + 2, (uint32_t)this->timer_heap.size()); child < end; child++) {
+        if (this->timer_heap[child].timeout_ns <= limit)
+            timeout = std::max(timeout, this->coalesced_timeout(child, limit));
+    }
+
+    return timeout;
+}
+
+uint64_t TimerManager::queue_timer(uint64_t timeout_ns, uint64_t interval_ns, timer_cb cb,
+                                   const char* label)
+{
+    uint32_t   slot_idx = this->alloc_slot();
+    TimerInfo& ti       = this->timer_slots[slot_idx];
+
+    ti.interval_ns = interval_ns;
+    ti.cb          = std::move(cb);
+#ifdef TIMER_PROFILING
+    ti.stats       = this->get_stats(label);
+#endif
 
     // add new timer to the timer queue
-    this->timer_queue.push(timer_desc);
+    this->heap_push(slot_idx, timeout_ns);
+
+    return ti.id;
+}
+
+bool TimerManager::dequeue_timer(uint64_t id)
+{
+    uint32_t slot_idx = (uint32_t)(id & ((1ULL << TIMER_SLOT_BITS) - 1)) - 1;
+
+    // ignore IDs of timers that already expired or were cancelled
+    if (slot_idx >= this->timer_slots.size() || this->timer_slots[slot_idx].id != id ||
+        this->timer_slots[slot_idx].heap_pos == TIMER_NOT_QUEUED)
+        return false;
+
+    this->heap_remove(this->timer_slots[slot_idx].heap_pos);
+
+    // a timer cancelling itself from its callback is freed once that returns
+    if (slot_idx != this->running_slot)
+        this->free_slot(slot_idx);
+
+    return true;
+}
+
+void TimerManager::post_request(TimerRequest* req)
+{
+    TimerRequest* head = this->posted_reqs.load(std::memory_order_relaxed);
+
+    do {
+        req->next = head;
+    } while (!this->posted_reqs.compare_exchange_weak(head, req, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+
+    // make the owner pick the request up at the next slice boundary
+    this->notify_timer_changes();
+}
+
+void TimerManager::process_requests(uint64_t time_now)
+{
+    TimerRequest* req = this->posted_reqs.exchange(nullptr, std::memory_order_acquire);
+
+    // restore the posting order
+    TimerRequest* prev = nullptr;
+    while (req) {
+        TimerRequest* next = req->next;
+        req->next = prev;
+        prev = req;
+        req  = next;
+    }
+
+    for (req = prev; req; req = prev) {
+        if (req->cancel_id)
+            this->dequeue_timer(req->cancel_id);
+        else
+            this->queue_timer(time_now + req->delay_ns, req->interval_ns, std::move(req->cb),
+                              req->label);
+        prev = req->next;
+        delete req;
+    }
+}
+
+uint64_t TimerManager::add_timer(uint64_t delay_ns, uint64_t interval_ns, timer_cb cb,
+                                 const char* label)
+{
+    if (std::this_thread::get_id() != this->owner_thread) {
+        this->post_request(new TimerRequest{nullptr, 0, delay_ns, interval_ns, std::move(cb),
+                                            label});
+        return 0;
+    }
+
+    uint64_t id = this->queue_timer(this->get_time_now() + delay_ns, interval_ns, std::move(cb),
+                                    label);
 
     // notify listeners about changes in the timer queue
     if (!this->cb_active) {
         this->notify_timer_changes();
     }
 
-    return ti->id;
+    return id;
 }
 
-uint32_t TimerManager::add_cyclic_timer(uint64_t interval, timer_cb cb) {
-    return this->add_cyclic_timer(interval, interval, cb);
+uint64_t TimerManager::add_oneshot_timer(uint64_t timeout, timer_cb cb, const char* label)
+{
+    return this->add_timer(timeout, 0, std::move(cb), label);
 }
 
-void TimerManager::cancel_timer(uint32_t id)
+uint64_t TimerManager::add_immediate_timer(timer_cb cb, const char* label) {
+    return this->add_timer(0, 0, std::move(cb), label);
+}
+
+uint64_t TimerManager::add_cyclic_timer(uint64_t interval, uint64_t delay, timer_cb cb,
+                                        const char* label)
 {
-    this->timer_queue.remove_by_id(id);
-    if (!this->cb_active) {
+    return this->add_timer(delay, interval, std::move(cb), label);
+}
+
+uint64_t TimerManager::add_cyclic_timer(uint64_t interval, timer_cb cb, const char* label) {
+    return this->add_cyclic_timer(interval, interval, std::move(cb), label);
+}
+
+void TimerManager::cancel_timer(uint64_t id)
+{
+    if (std::this_thread::get_id() != this->owner_thread) {
+        this->post_request(new TimerRequest{nullptr, id, 0, 0, nullptr, nullptr});
+        return;
+    }
+
+    if (this->dequeue_timer(id) && !this->cb_active) {
         this->notify_timer_changes();
     }
 }
 
 uint64_t TimerManager::process_timers()
 {
-    std::shared_ptr<TimerInfo> cur_timer;
     uint64_t time_now = get_time_now();
 
-{ // mtx scope
-    std::lock_guard<std::recursive_mutex> lk(this->timer_queue.get_mtx());
-    if (this->timer_queue.empty()) {
-        return 0ULL;
+    // pick up requests from other threads
+    if (this->posted_reqs.load(std::memory_order_relaxed)) {
+        this->process_requests(time_now);
     }
 
     // scan for expired timers
-    cur_timer = this->timer_queue.top();
-} // ] mtx scope
-    while (cur_timer->timeout_ns <= time_now) {
-        timer_cb cb = cur_timer->cb;
-
-        // re-arm cyclic timers
-        if (cur_timer->interval_ns) {
-            std::lock_guard<std::recursive_mutex> lk(this->timer_queue.get_mtx());
-            cur_timer->timeout_ns = time_now + cur_timer->interval_ns;
-            this->timer_queue.remove_by_id(cur_timer->id);
-            this->timer_queue.push(cur_timer);
+    while (!this->timer_heap.empty()) {
+        TimerHeapEntry top       = this->timer_heap[0];
+        uint32_t       slot_idx  = top.slot_idx;
+        TimerInfo&     cur_timer = this->timer_slots[slot_idx];
+
+        if (top.timeout_ns > time_now) {
+            // return time slice in nanoseconds until next timer's expiry,
+            // extended to cover timers expiring shortly after it
+            uint64_t timeout = top.timeout_ns;
+            if (this->timer_slack_ns)
+                timeout = this->coalesced_timeout(0, timeout + this->timer_slack_ns);
+            return timeout - time_now;
+        }
+
+#ifdef TIMER_PROFILING
+        TimerStats* stats = cur_timer.stats;
+        uint64_t    late  = time_now - top.timeout_ns;
+#endif
+
+        if (cur_timer.interval_ns) {
+            // re-arm cyclic timers in place
+            top.timeout_ns = time_now + cur_timer.interval_ns;
+            this->sift_down(0, top);
         } else {
             // remove one-shot timers from queue
-            this->timer_queue.pop();
+            this->heap_remove(0);
         }
 
+        this->running_slot = slot_idx;
         this->cb_active = true;
 
-        // invoke timer callback
-        cb();
+        // invoke timer callback, it may add or cancel timers
+#ifdef TIMER_PROFILING
+        auto start = std::chrono::steady_clock::now();
+        cur_timer.cb();
+        uint64_t host_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        stats->calls++;
+        stats->host_ns += host_ns;
+        stats->host_max_ns = std::max(stats->host_max_ns, host_ns);
+        stats->late_max_ns = std::max(stats->late_max_ns, late);
+        stats->host_hist[hist_bucket(host_ns)]++;
+        stats->late_hist[hist_bucket(late)]++;
+#else
+        cur_timer.cb();
+#endif
 
         this->cb_active = false;
+        this->running_slot = TIMER_NO_SLOT;
 
-        // process next timer
-{ // [ mtx scope
-        std::lock_guard<std::recursive_mutex> lk(this->timer_queue.get_mtx());
-        if (this->timer_queue.empty()) {
-            return 0ULL;
-        }
-
-        cur_timer = this->timer_queue.top();
-} // ] mtx scope
+        // free expired one-shot timers and cyclic timers cancelled meanwhile
+        if (cur_timer.heap_pos == TIMER_NOT_QUEUED)
+            this->free_slot(slot_idx);
     }
 
-    // return time slice in nanoseconds until next timer's expiry
-    return cur_timer->timeout_ns - time_now;
+    return 0ULL;
 }
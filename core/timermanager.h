@@ -26,13 +26,17 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <algorithm>
 #include <cinttypes>
 #include <functional>
-#include <memory>
-#include <queue>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
-#include <mutex>
 
 using namespace std;
 
+//#define TIMER_PROFILING // enable timer callback profiling
+
 #define NS_PER_SEC      1E9
 #define USEC_PER_SEC    1E6
 #define NS_PER_USEC     1000UL
@@ -44,67 +48,62 @@ using namespace std;
 
 typedef function<void()> timer_cb;
 
-/** Extend std::priority_queue as suggested here:
-    https://stackoverflow.com/a/36711682
-    to be able to remove arbitrary elements.
+#ifdef TIMER_PROFILING
+/** Number of histogram buckets: < 1 us, < 10 us, < 100 us, < 1 ms, < 10 ms, more. */
+#define TIMER_HIST_BUCKETS  6
+
+/** Callback statistics for all timers sharing a label. */
+typedef struct TimerStats {
+    uint64_t calls;
+    uint64_t host_ns;       // host time spent in callbacks
+    uint64_t host_max_ns;
+    uint64_t late_max_ns;   // virtual time between expiry and invocation
+    uint64_t host_hist[TIMER_HIST_BUCKETS];
+    uint64_t late_hist[TIMER_HIST_BUCKETS];
+} TimerStats;
+#endif
+
+/** Timer descriptor. Descriptors live in a pool and are recycled, the ID
+    handed out for a timer encodes its pool slot and the slot's generation
+    so stale IDs can be told apart from the current occupant. The generation
+    is 48 bits wide, so IDs are never reused in practice, even for a slot
+    recycled millions of times per second.
  */
-template <typename T, class Container = std::vector<T>, class Compare = std::less<typename Container::value_type>>
-class my_priority_queue : public std::priority_queue<T, Container, Compare> {
-public:
-    bool remove_by_id(const uint32_t id){
-        std::lock_guard<std::recursive_mutex> lk(mtx);
-        auto el = this->top();
-        if (el->id == id) {
-            std::priority_queue<T, Container, Compare>::pop();
-            return true;
-        }
-        auto it = std::find_if(
-            this->c.begin(), this->c.end(), [id](const T& el) { return el->id == id; });
-        if (it != this->c.end()) {
-            this->c.erase(it);
-            std::make_heap(this->c.begin(), this->c.end(), this->comp);
-            return true;
-        }
-        return false;
-    };
-
-    void push(T val)
-    {
-        std::lock_guard<std::recursive_mutex> lk(mtx);
-        std::priority_queue<T, Container, Compare>::push(val);
-    };
-
-    T pop()
-    {
-        std::lock_guard<std::recursive_mutex> lk(mtx);
-        T val = std::priority_queue<T, Container, Compare>::top();
-        std::priority_queue<T, Container, Compare>::pop();
-        return val;
-    };
-
-    std::recursive_mutex& get_mtx()
-    {
-        return mtx;
-    }
-
-private:
-    std::recursive_mutex mtx;
-};
-
 typedef struct TimerInfo {
-    uint32_t id;
-    uint64_t timeout_ns;  // timer expiry
     uint64_t interval_ns; // 0 for one-shot timers
     timer_cb cb;          // timer callback
+#ifdef TIMER_PROFILING
+    TimerStats* stats;    // statistics for the timer's label
+#endif
+    uint64_t id;          // 0 if the slot is free
+    uint32_t heap_pos;    // position in the timer heap, TIMER_NOT_QUEUED if none
+    uint32_t next_free;   // next free slot if the slot is free
+    uint64_t gen;         // bumped every time the slot is reused
 } TimerInfo;
 
-// Custom comparator for sorting our timer queue in ascending order
-class MyGtComparator {
-public:
-    bool operator()(const shared_ptr<TimerInfo>& l, const shared_ptr<TimerInfo>& r) {
-        return l.get()->timeout_ns > r.get()->timeout_ns;
-    }
-};
+/** Timer heap entry, expiry is kept here to keep heap operations local. */
+typedef struct TimerHeapEntry {
+    uint64_t timeout_ns;  // timer expiry
+    uint32_t slot_idx;
+} TimerHeapEntry;
+
+/** Timer request posted by a thread other than the emulation thread. */
+typedef struct TimerRequest {
+    TimerRequest* next;
+    uint64_t      cancel_id;    // ID of the timer to cancel, 0 to add a timer
+    uint64_t      delay_ns;     // relative to the time the request is picked up
+    uint64_t      interval_ns;
+    timer_cb      cb;
+    const char*   label;
+} TimerRequest;
+
+/** Default window within which timers expiring after the first
+    one are processed together with it. */
+#define TIMER_SLACK_NS      1000
+
+#define TIMER_SLOT_BITS     16
+#define TIMER_NOT_QUEUED    0xFFFFFFFFUL
+#define TIMER_NO_SLOT       0xFFFFFFFFUL
 
 class TimerManager {
 public:
@@ -115,9 +114,10 @@ public:
         return timer_manager;
     };
 
-    // callback for retrieving current time
+    // callback for retrieving current time, timers are owned by the calling thread
     void set_time_now_cb(const function<uint64_t()> &cb) {
         this->get_time_now = cb;
+        this->owner_thread = std::this_thread::get_id();
     };
 
     // callback for acknowledging time changes
@@ -125,30 +125,83 @@ public:
         this->notify_timer_changes = cb;
     };
 
+    // timers expiring up to slack_ns after the next one are deferred
+    // and processed together with it, 0 disables coalescing
+    void set_timer_slack(uint64_t slack_ns) {
+        this->timer_slack_ns = slack_ns;
+    };
+
     // return current virtual time in nanoseconds
     uint64_t current_time_ns() { return get_time_now(); };
 
     // creating and cancelling timers
-    uint32_t add_oneshot_timer(uint64_t timeout, timer_cb cb);
-    uint32_t add_immediate_timer(timer_cb cb);
-    uint32_t add_cyclic_timer(uint64_t interval, timer_cb cb);
-    uint32_t add_cyclic_timer(uint64_t interval, uint64_t delay, timer_cb cb);
-    void cancel_timer(uint32_t id);
+    // When called from another thread than the owner, the request is queued
+    // until the owner processes timers next and 0 is returned instead of an ID.
+    // With TIMER_PROFILING, callback statistics are collected per label,
+    // which must be a string that stays valid, usually a literal.
+    uint64_t add_oneshot_timer(uint64_t timeout, timer_cb cb, const char* label = nullptr);
+    uint64_t add_immediate_timer(timer_cb cb, const char* label = nullptr);
+    uint64_t add_cyclic_timer(uint64_t interval, timer_cb cb, const char* label = nullptr);
+    uint64_t add_cyclic_timer(uint64_t interval, uint64_t delay, timer_cb cb,
+                              const char* label = nullptr);
+    void cancel_timer(uint64_t id);
 
     uint64_t process_timers();
 
+#ifdef TIMER_PROFILING
+    // callback statistics, reported by the "Timers" profile
+    void register_profile();
+    const map<string, TimerStats>& get_timer_stats() { return this->timer_stats; };
+    void reset_timer_stats();
+#endif
+
 private:
     static TimerManager* timer_manager;
     TimerManager(){}; // private constructor to implement a singleton
 
-    // timer queue
-    my_priority_queue<shared_ptr<TimerInfo>, vector<shared_ptr<TimerInfo>>, MyGtComparator> timer_queue;
+    uint64_t add_timer(uint64_t delay_ns, uint64_t interval_ns, timer_cb cb, const char* label);
+    uint64_t queue_timer(uint64_t timeout_ns, uint64_t interval_ns, timer_cb cb,
+                         const char* label);
+#ifdef TIMER_PROFILING
+    TimerStats* get_stats(const char* label);
+#endif
+    bool     dequeue_timer(uint64_t id);
+
+    // lock-free submission of requests by other threads
+    void post_request(TimerRequest* req);
+    void process_requests(uint64_t time_now);
+
+    // timer pool
+    uint32_t alloc_slot();
+    void     free_slot(uint32_t slot_idx);
+
+    // min-heap of slot indices ordered by expiry
+    void heap_push(uint32_t slot_idx, uint64_t timeout_ns);
+    void heap_remove(uint32_t pos);
+    void sift_up(uint32_t pos, TimerHeapEntry entry);
+    void sift_down(uint32_t pos, TimerHeapEntry entry);
+    uint64_t coalesced_timeout(uint32_t pos, uint64_t limit);
+
+    // slots never move once allocated, unlike with a vector
+    deque<TimerInfo>        timer_slots;
+    vector<TimerHeapEntry>  timer_heap;
+    uint32_t                free_head    = TIMER_NO_SLOT;
+    uint32_t                running_slot = TIMER_NO_SLOT; // slot whose callback is executing
+
+    std::atomic<TimerRequest*>  posted_reqs{nullptr}; // LIFO list
+    std::thread::id             owner_thread;
+
+    uint64_t                timer_slack_ns = TIMER_SLACK_NS;
+
+#ifdef TIMER_PROFILING
+    map<string, TimerStats>                     timer_stats; // by label
+    unordered_map<const char*, TimerStats*>     label_stats; // by label address
+#endif
 
     function<uint64_t()>   get_time_now;
     function<void()>       notify_timer_changes;
 
-    std::atomic<uint32_t> id{0};
-    bool        cb_active = false; // true if a timer callback is executing // FIXME: Do we need this? It gets written in main thread and read in audio thread.
+    bool        cb_active = false; // true if a timer callback is executing
 };
 
 #endif // TIMER_MANAGER_H
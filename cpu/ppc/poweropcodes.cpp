@@ -41,7 +41,7 @@ void dppc_interpreter::power_abs() {
     if (ppc_result_a == 0x80000000) {
         ppc_result_d = ppc_result_a;
         if (ov)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
     } else {
         ppc_result_d = (int32_t(ppc_result_a) < 0) ? -ppc_result_a : ppc_result_a;
         if (ov)
@@ -97,19 +97,19 @@ void dppc_interpreter::power_div() {
         remainder = 0;
         ppc_result_d = 0x80000000U; // -2^31 aka INT32_MIN
         if (ov)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
     } else if (!divisor) {
         remainder = 0;
         ppc_result_d = 0x80000000U; // -2^31 aka INT32_MIN
         if (ov)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
     } else {
         quotient = dividend / divisor;
         remainder = dividend % divisor;
         ppc_result_d = uint32_t(quotient);
         if (ov) {
             if (((quotient >> 31) + 1) & ~1) {
-                ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+                ppc_xer_overflow();
             } else {
                 ppc_state.spr[SPR::XER] &= ~XER::OV;
             }
@@ -138,12 +138,12 @@ void dppc_interpreter::power_divs() {
         ppc_result_d = -1;
         remainder = ppc_result_a;
         if (ov)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
     } else if (ppc_result_a == 0x80000000U && ppc_result_b == 0xFFFFFFFFU) {
         ppc_result_d = 0x80000000U;
         remainder = 0;
         if (ov)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
     } else { // normal signed devision
         ppc_result_d = int32_t(ppc_result_a) / int32_t(ppc_result_b);
         remainder = (int32_t(ppc_result_a) % int32_t(ppc_result_b));
@@ -170,7 +170,7 @@ void dppc_interpreter::power_doz() {
 
     if (ov) {
         if (int32_t(ppc_result_d) < 0) {
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
         } else {
             ppc_state.spr[SPR::XER] &= ~XER::OV;
         }
@@ -213,6 +213,8 @@ void dppc_interpreter::power_lscbx() {
 
     while (bytes_remaining > 0) {
         uint8_t return_value = mmu_read_vmem<uint8_t>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
 
         ppc_result_d |= return_value << shift_amount;
         if (!shift_amount) {
@@ -241,6 +243,7 @@ void dppc_interpreter::power_lscbx() {
     ppc_state.spr[SPR::XER] = (ppc_state.spr[SPR::XER] & ~0x7F) | (bytes_to_load - bytes_remaining);
 
     if (rec) {
+        ppc_cr_sync();
         ppc_state.cr =
             (ppc_state.cr & 0x0FFFFFFFUL) |
             (is_match ? CRx_bit::CR_EQ : 0) |
@@ -302,7 +305,7 @@ void dppc_interpreter::power_mul() {
 
     if (ov) {
         if (uint64_t(product >> 31) + 1 & ~1) {
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
         } else {
             ppc_state.spr[SPR::XER] &= ~XER::OV;
         }
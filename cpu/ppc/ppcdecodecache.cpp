@@ -0,0 +1,163 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Cache of predecoded PowerPC instructions. */
+
+#include <loguru.hpp>
+#include <memaccess.h>
+#include "ppcdecodecache.h"
+#include "ppcidle.h"
+#include "ppcjit.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// pages are aligned to their size so that the page end can be told from a slot pointer
+typedef struct alignas(sizeof(DecodedInstr) * DC_PAGE_SLOTS) DecodedPage {
+    DecodedInstr    instrs[DC_PAGE_SLOTS];
+} DecodedPage;
+
+static_assert(sizeof(DecodedPage) == sizeof(DecodedInstr) * DC_PAGE_SLOTS,
+              "DecodedPage must not be padded");
+
+// two-level page directory indexed by physical address bits 31:22 and 21:12
+static DecodedPage** page_dir[1024];
+
+// all pages allocated so far
+static std::vector<DecodedPage*> dc_pages;
+
+uint32_t dc_code_page_bits[(1 << 20) / 32];
+
+DecodedInstr* decode_cache_get_page(uint32_t phys_addr)
+{
+    DecodedPage** dir = page_dir[phys_addr >> 22];
+
+    if (!dir) {
+        dir = page_dir[phys_addr >> 22] = new DecodedPage*[1024]();
+    }
+
+    DecodedPage* page = dir[(phys_addr >> 12) & 0x3FF];
+
+    if (!page) {
+        if (dc_pages.size() >= DC_MAX_PAGES) {
+            LOG_F(9, "Decode cache full, flushing");
+            decode_cache_flush();
+            return decode_cache_get_page(phys_addr);
+        }
+        page = new DecodedPage();
+        dir[(phys_addr >> 12) & 0x3FF] = page;
+        dc_pages.push_back(page);
+
+        uint32_t pn = phys_addr >> 12;
+        dc_code_page_bits[pn >> 5] |= 1U << (pn & 31);
+    }
+
+    return page->instrs;
+}
+
+static inline void decode_slot(DecodedInstr* slot, const uint8_t* host_va)
+{
+    slot->opcode  = READ_DWORD_BE_A(host_va);
+    slot->handler = ppc_decode_opcode(slot->opcode);
+    slot->flags   = 0;
+}
+
+void decode_cache_fill(DecodedInstr* slot, const uint8_t* host_va)
+{
+    decode_slot(slot, host_va);
+
+    // pairs are never fused across a page boundary
+    if (!((uintptr_t)(slot + 1) & (sizeof(DecodedPage) - 1)))
+        return;
+
+    PPCOpcode fused = ppc_fuse_opcodes(slot->opcode, READ_DWORD_BE_A(host_va + 4));
+    if (fused) {
+        // the fused handler takes the second instruction from the next slot
+        if (!slot[1].handler)
+            decode_slot(&slot[1], host_va + 4);
+        slot->handler = fused;
+        slot->flags   = DC_FLAG_FUSED;
+    }
+}
+
+void decode_cache_invalidate(uint32_t phys_addr, uint32_t size)
+{
+    if (!size)
+        return;
+
+    uint64_t end = (uint64_t)phys_addr + size;
+
+    while (phys_addr < end) {
+        uint32_t pn = phys_addr >> 12;
+        uint32_t page_end = (phys_addr | 0xFFFU);
+        uint32_t last = (end - 1 < page_end) ? (uint32_t)(end - 1) : page_end;
+
+        if (dc_code_page_bits[pn >> 5] & (1U << (pn & 31))) {
+            DecodedInstr* slots = page_dir[phys_addr >> 22][pn & 0x3FF]->instrs;
+            uint32_t jit_flags  = 0;
+            uint32_t first_slot = (phys_addr & 0xFFF) >> 2;
+            uint32_t last_slot  = (last & 0xFFF) >> 2;
+            for (uint32_t i = first_slot; i <= last_slot; i++) {
+                slots[i].handler = nullptr;
+                jit_flags |= slots[i].flags;
+            }
+
+            // a pair fused with the first overwritten instruction needs to be decoded again
+            if (first_slot && (slots[first_slot - 1].flags & DC_FLAG_FUSED))
+                slots[first_slot - 1].handler = nullptr;
+
+            // idle loop verdicts are kept on the loop branch which may follow
+            // the overwritten instructions
+            last_slot = std::min(last_slot + IDLE_LOOP_MAX_INSTRS - 1, DC_PAGE_SLOTS - 1);
+            for (uint32_t i = first_slot; i <= last_slot; i++)
+                slots[i].flags &= ~(DC_FLAG_IDLE_CHECKED | DC_FLAG_IDLE_LOOP);
+
+            // overwritten code was translated -> drop all blocks of this page
+            if (jit_flags & DC_FLAG_JIT) {
+                ppc_jit_invalidate_page(phys_addr);
+                for (uint32_t i = 0; i < DC_PAGE_SLOTS; i++)
+                    slots[i].flags &= ~DC_FLAG_JIT;
+            }
+        }
+
+        if (page_end == 0xFFFFFFFFUL)
+            break;
+        phys_addr = page_end + 1;
+    }
+}
+
+void decode_cache_flush()
+{
+    for (auto page : dc_pages)
+        delete page;
+    dc_pages.clear();
+
+    for (auto& dir : page_dir) {
+        delete[] dir;
+        dir = nullptr;
+    }
+
+    std::memset(dc_code_page_bits, 0, sizeof(dc_code_page_bits));
+
+    // translated blocks refer to the slots
+    ppc_jit_flush();
+}
@@ -0,0 +1,80 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Cache of predecoded PowerPC instructions.
+
+    Instructions are decoded once into their leaf handler and kept
+    in per-page arrays indexed by the guest physical address.
+    A slot is decoded lazily on first execution and dropped again
+    when the guest or a DMA engine writes to the underlying memory.
+    Frequent instruction pairs are fused into a single handler
+    kept in the slot of the first instruction.
+ */
+
+#ifndef PPC_DECODE_CACHE_H
+#define PPC_DECODE_CACHE_H
+
+#include "ppcemu.h"
+
+#include <cinttypes>
+
+constexpr uint32_t DC_PAGE_SLOTS = 1024; // instruction slots per 4K page
+constexpr uint32_t DC_MAX_PAGES  = 2048; // max number of cached pages
+
+/** Predecoded instruction slot. */
+typedef struct DecodedInstr {
+    PPCOpcode   handler; // leaf handler, nullptr if not decoded yet
+    uint32_t    opcode;  // raw instruction word
+    uint32_t    flags;   // DC_FLAG_XXX
+} DecodedInstr;
+
+enum : uint32_t {
+    DC_FLAG_JIT          = 1 << 0, // instruction is part of a translated block
+    DC_FLAG_IDLE_CHECKED = 1 << 1, // loop ending here has been checked for idling
+    DC_FLAG_IDLE_LOOP    = 1 << 2, // loop ending here is an idle loop
+    DC_FLAG_FUSED        = 1 << 3, // handler executes this and the next instruction
+};
+
+/** One bit per physical page that holds predecoded instructions. */
+extern uint32_t dc_code_page_bits[];
+
+/** Return the slot array for the physical page containing phys_addr.
+    Allocates a new page if necessary. */
+extern DecodedInstr* decode_cache_get_page(uint32_t phys_addr);
+
+/** Decode the instruction at host_va into the given slot.
+    Also decodes the next slot if both can be fused. */
+extern void decode_cache_fill(DecodedInstr* slot, const uint8_t* host_va);
+
+/** Drop all slots overlapping the physical range [phys_addr, phys_addr + size). */
+extern void decode_cache_invalidate(uint32_t phys_addr, uint32_t size);
+
+/** Drop all predecoded instructions. */
+extern void decode_cache_flush();
+
+/** Fast check to be called on each write to guest memory. */
+inline void decode_cache_notify_write(uint32_t phys_addr, uint32_t size) {
+    uint32_t pn = phys_addr >> 12;
+    if (dc_code_page_bits[pn >> 5] & (1U << (pn & 31)))
+        decode_cache_invalidate(phys_addr, size);
+}
+
+#endif // PPC_DECODE_CACHE_H
@@ -29,7 +29,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <atomic>
 #include <cinttypes>
 #include <functional>
-#include <setjmp.h>
+#include <set>
 #include <string>
 
 // Uncomment this to have a more graceful approach to illegal opcodes
@@ -185,6 +185,7 @@ enum {
     EXEF_BRANCH    = 1 << 0,
     EXEF_EXCEPTION = 1 << 1,
     EXEF_RFI       = 1 << 2,
+    EXEF_ABORT     = 1 << 3, // current instruction raised a synchronous exception
 };
 
 enum CR_select : int32_t {
@@ -300,8 +301,13 @@ enum Exc_Cause : uint32_t {
 };
 
 extern unsigned exec_flags;
+extern std::atomic<bool> events_pending;
 
-extern jmp_buf exc_env;
+/* Tells whether the current instruction has been aborted by an exception.
+   Instruction handlers must return without further side effects then. */
+inline bool ppc_instr_aborted() {
+    return exec_flags & EXEF_ABORT;
+}
 
 extern bool grab_return;
 
@@ -333,6 +339,12 @@ extern uint32_t ppc_cur_instruction;
 extern uint32_t ppc_effective_address;
 extern uint32_t ppc_next_instruction_address;
 
+// Executed instruction counter driving virtual time
+extern uint64_t g_icycles;
+
+// Tells whether virtual time is paced to the host's wall clock
+extern bool g_realtime;
+
 inline void ppc_set_cur_instruction(const uint8_t* ptr) {
     ppc_cur_instruction = READ_DWORD_BE_A(ptr);
 }
@@ -344,6 +356,7 @@ extern uint64_t num_supervisor_instrs;
 extern uint64_t num_int_loads;
 extern uint64_t num_int_stores;
 extern uint64_t exceptions_processed;
+extern uint64_t num_idle_cycles_skipped;
 #endif
 
 // instruction enums
@@ -410,17 +423,51 @@ void ppc_release_int();
 //void ppc_opcode4();
 void ppc_opcode16();
 void ppc_opcode18();
-template <field_601 for601> void ppc_opcode19();
+void ppc_opcode19();
 void ppc_opcode31();
 void ppc_opcode59();
 void ppc_opcode63();
 
 void initialize_ppc_opcode_tables(bool include_601);
+PPCOpcode ppc_decode_opcode(uint32_t opcode);
+PPCOpcode ppc_fuse_opcodes(uint32_t first, uint32_t second);
 
 extern double fp_return_double(uint32_t reg);
 extern uint64_t fp_return_uint64(uint32_t reg);
 
-void ppc_changecrf0(uint32_t set_result);
+/* CR0 updates of record-form integer instructions are evaluated lazily:
+   the instruction only saves its result, CR0 gets computed from it and
+   XER[SO] when something actually looks at the CR. Code accessing
+   ppc_state.cr or changing XER[SO] must call ppc_cr_sync() first,
+   code replacing the whole CR must use ppc_cr_set(). */
+extern bool     cr0_pending;
+extern uint32_t cr0_result;
+
+extern void ppc_cr0_materialize();
+
+// Affects CR Field 0 - For integer operations
+inline void ppc_changecrf0(uint32_t set_result) {
+    cr0_result  = set_result;
+    cr0_pending = true;
+}
+
+inline void ppc_cr_sync() {
+    if (cr0_pending)
+        ppc_cr0_materialize();
+}
+
+// Replace the whole CR, discarding any pending CR0 update
+inline void ppc_cr_set(uint32_t val) {
+    cr0_pending  = false;
+    ppc_state.cr = val;
+}
+
+// Set XER[OV] and the sticky XER[SO]
+inline void ppc_xer_overflow() {
+    ppc_cr_sync(); // a pending CR0 still needs the old XER[SO]
+    ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+}
+
 void set_host_rounding_mode(uint8_t mode);
 void update_fpscr(uint32_t new_fpscr);
 
@@ -650,6 +697,7 @@ extern void ppc_main_opcode(void);
 extern void ppc_exec(void);
 extern void ppc_exec_single(void);
 extern void ppc_exec_until(uint32_t goal_addr);
+extern void ppc_exec_until(const std::set<uint32_t>& goal_addrs);
 extern void ppc_exec_dbg(uint32_t start_addr, uint32_t size);
 
 /* debugging support API */
@@ -25,12 +25,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "ppcemu.h"
 #include "ppcmmu.h"
 
-#include <setjmp.h>
 #include <stdexcept>
 #include <string>
 
-jmp_buf exc_env; /* Global exception environment. */
-
 void ppc_exception_handler(Except_Type exception_type, uint32_t srr1_bits) {
 #ifdef CPU_PROFILING
     exceptions_processed++;
@@ -131,8 +128,10 @@ void ppc_exception_handler(Except_Type exception_type, uint32_t srr1_bits) {
 
     mmu_change_mode();
 
+    // synchronous exceptions abort the current instruction, the execution
+    // loop continues at the exception vector once the handler returns
     if (exception_type != Except_Type::EXC_EXT_INT && exception_type != Except_Type::EXC_DECR) {
-        longjmp(exc_env, 2); /* return to the main execution loop. */
+        exec_flags |= EXEF_ABORT;
     }
 }
 
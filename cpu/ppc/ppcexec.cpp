@@ -24,12 +24,18 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "ppcemu.h"
 #include "ppcmmu.h"
 #include "ppcdisasm.h"
+#include "ppcdecodecache.h"
+#include "ppcidle.h"
+#include "ppcjit.h"
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
 #include <map>
-#include <setjmp.h>
+#include <mutex>
+#include <set>
 #include <stdexcept>
 #include <stdio.h>
 #include <string>
@@ -50,6 +56,17 @@ ConvertHostTimeToNanos2(uint64_t host_time)
 }
 #endif
 
+// threaded dispatch relies on the labels-as-values extension of GCC/Clang
+#if defined(PPC_THREADED_DISPATCH) && defined(__GNUC__)
+#define PPC_COMPUTED_GOTO
+#if defined(__clang__)
+#define PPC_NO_CROSSJUMPING
+#else
+// keep GCC from merging the replicated dispatch code back into one jump
+#define PPC_NO_CROSSJUMPING __attribute__((optimize("no-crossjumping")))
+#endif
+#endif
+
 using namespace std;
 using namespace dppc_interpreter;
 
@@ -70,24 +87,39 @@ uint32_t ppc_effective_address;
 uint32_t ppc_next_instruction_address;    // Used for branching, setting up the NIA
 
 unsigned exec_flags; // execution control flags
-// FIXME: exec_timer is read by main thread ppc_main_opcode;
-// written by audio dbdma DMAChannel::update_irq .. add_immediate_timer
-volatile bool exec_timer;
+// set by any thread changing the timer queue, polled by the execution loops
+std::atomic<bool> events_pending;
 bool int_pin = false; // interrupt request pin state: true - asserted
 bool dec_exception_pending = false;
 
-/* copy of local variable bb_start_la. Need for correct
-   calculation of CPU cycles after setjmp that clobbers
-   non-volatile local variables. */
-uint32_t    glob_bb_start_la;
-
 /* variables related to virtual time */
-const bool g_realtime = false;
-uint64_t g_nanoseconds_base;
-uint64_t g_icycles_base;
+bool     g_realtime = false;
+uint64_t g_nanoseconds_base;    // host time at virtual time 0 in real-time mode
+uint64_t g_icycles_base;        // g_icycles at the last instruction rate change
 uint64_t g_icycles;
 int      icnt_factor;
 
+/* real-time mode: virtual time advances by g_ns_per_cycle per instruction,
+   which is recalibrated to the speed the host actually executes them at */
+constexpr int      RT_RATE_SHIFT      = 16;           // fractional bits of g_ns_per_cycle
+constexpr uint64_t RT_RATE_MIN        = 1ULL << 12;   // 1/16 ns per instruction
+constexpr uint64_t RT_RATE_MAX        = 1000ULL << RT_RATE_SHIFT;
+constexpr uint64_t RT_CALIBRATE_NS    = 20000000ULL;  // calibration window
+constexpr uint64_t RT_MIN_SLEEP_NS    = 500000ULL;    // don't sleep for less than that
+constexpr uint64_t RT_MAX_SLEEP_NS    = 100000000ULL;
+constexpr uint64_t RT_MAX_LAG_NS      = 200000000ULL; // give up catching up beyond that
+
+uint64_t g_virt_ns_base;        // virtual time at the last instruction rate change
+uint64_t g_ns_per_cycle;        // fixed point with RT_RATE_SHIFT fractional bits
+
+static uint64_t rt_window_start;    // host time the calibration window started at
+static uint64_t rt_window_icycles;
+static uint64_t rt_window_skipped;
+static uint64_t rt_window_slept;
+
+static std::mutex              rt_mtx;
+static std::condition_variable rt_cv;
+
 /* global variables related to the timebase facility */
 uint64_t tbr_wr_timestamp;  // stores vCPU virtual time of the last TBR write
 uint64_t rtc_timestamp;     // stores vCPU virtual time of the last RTC write
@@ -110,6 +142,8 @@ uint64_t num_supervisor_instrs;
 uint64_t num_int_loads;
 uint64_t num_int_stores;
 uint64_t exceptions_processed;
+uint64_t num_idle_cycles_skipped;
+uint64_t num_event_checks;
 #ifdef CPU_PROFILING_OPS
 std::unordered_map<uint32_t, uint64_t> num_opcodes;
 #endif
@@ -144,6 +178,14 @@ public:
                         .format = ProfileVarFmt::DEC,
                         .value = exceptions_processed});
 
+        vars.push_back({.name = "Idle Cycles Skipped",
+                        .format = ProfileVarFmt::DEC,
+                        .value = num_idle_cycles_skipped});
+
+        vars.push_back({.name = "Event Checks",
+                        .format = ProfileVarFmt::DEC,
+                        .value = num_event_checks});
+
         // Generate top N op counts with readable names.
 #ifdef CPU_PROFILING_OPS
         PPCDisasmContext ctx;
@@ -175,6 +217,8 @@ public:
         num_int_loads = 0;
         num_int_stores = 0;
         exceptions_processed = 0;
+        num_idle_cycles_skipped = 0;
+        num_event_checks = 0;
 #ifdef CPU_PROFILING_OPS
         num_opcodes.clear();
 #endif
@@ -201,6 +245,9 @@ const static PPCOpcode SubOpcode18Grabber[] = {
     dppc_interpreter::ppc_b<LK0, AA1>,      // ba
     dppc_interpreter::ppc_b<LK1, AA1>};     // bla
 
+/** Lookup table for condition register and branch conditional to LR/CTR instructions. */
+static PPCOpcode SubOpcode19Grabber[2048];
+
 /** Instructions decoding tables for integer,
     single floating-point, and double-floating point ops respectively */
 
@@ -208,6 +255,16 @@ static PPCOpcode SubOpcode31Grabber[2048];
 static PPCOpcode SubOpcode59Grabber[64];
 static PPCOpcode SubOpcode63Grabber[2048];
 
+#ifdef PPC_THREADED_DISPATCH
+/** Flattened lookup table covering all primary/extended opcode combinations.
+    Indexed by the primary opcode (bits 0...5) and bits 21...31. */
+static PPCOpcode FlatOpcodeGrabber[64 * 2048];
+
+static inline uint32_t flat_opcode_index(uint32_t opcode) {
+    return ((opcode >> 15) & 0x1F800) | (opcode & 0x7FF);
+}
+#endif
+
 /** Exception helpers. */
 
 void ppc_illegalop() {
@@ -242,64 +299,11 @@ void ppc_opcode18() {
     SubOpcode18Grabber[ppc_cur_instruction & 3]();
 }
 
-template<field_601 for601>
 void ppc_opcode19() {
-    uint16_t subop_grab = ppc_cur_instruction & 0x7FF;
-
-    switch (subop_grab) {
-    case 0:
-        ppc_mcrf();
-        break;
-    case 32:
-        ppc_bclr<LK0>();
-        break;
-    case 33:
-        ppc_bclr<LK1>();
-        break;
-    case 66:
-        ppc_crnor();
-        break;
-    case 100:
-        ppc_rfi();
-        break;
-    case 258:
-        ppc_crandc();
-        break;
-    case 300:
-        ppc_isync();
-        break;
-    case 386:
-        ppc_crxor();
-        break;
-    case 450:
-        ppc_crnand();
-        break;
-    case 514:
-        ppc_crand();
-        break;
-    case 578:
-        ppc_creqv();
-        break;
-    case 834:
-        ppc_crorc();
-        break;
-    case 898:
-        ppc_cror();
-        break;
-    case 1056:
-        ppc_bcctr<LK0, for601>();
-        break;
-    case 1057:
-        ppc_bcctr<LK1, for601>();
-        break;
-    default:
-        ppc_illegalop();
-    }
+    uint16_t subop_grab = ppc_cur_instruction & 0x7FFUL;
+    SubOpcode19Grabber[subop_grab]();
 }
 
-template void ppc_opcode19<NOT601>();
-template void ppc_opcode19<IS601>();
-
 void ppc_opcode31() {
     uint16_t subop_grab = ppc_cur_instruction & 0x7FFUL;
     SubOpcode31Grabber[subop_grab]();
@@ -315,8 +319,7 @@ void ppc_opcode63() {
     SubOpcode63Grabber[subop_grab]();
 }
 
-/* Dispatch using main opcode */
-void ppc_main_opcode()
+static inline void ppc_profile_instr()
 {
 #ifdef CPU_PROFILING
     num_executed_instrs++;
@@ -324,7 +327,119 @@ void ppc_main_opcode()
     num_opcodes[ppc_cur_instruction]++;
 #endif
 #endif
+}
+
+/* Dispatch using main opcode */
+void ppc_main_opcode()
+{
+    ppc_profile_instr();
+#ifdef PPC_THREADED_DISPATCH
+    FlatOpcodeGrabber[flat_opcode_index(ppc_cur_instruction)]();
+#else
     OpcodeGrabber[(ppc_cur_instruction >> 26) & 0x3F]();
+#endif
+}
+
+/** Resolve the leaf handler for an instruction word
+    without going through the secondary dispatchers. */
+static PPCOpcode ppc_resolve_opcode(uint32_t opcode)
+{
+    switch (opcode >> 26) {
+    case 16:
+        return SubOpcode16Grabber[opcode & 3];
+    case 18:
+        return SubOpcode18Grabber[opcode & 3];
+    case 19:
+        return SubOpcode19Grabber[opcode & 0x7FF];
+    case 31:
+        return SubOpcode31Grabber[opcode & 0x7FF];
+    case 59:
+        return SubOpcode59Grabber[opcode & 0x3F];
+    case 63:
+        return SubOpcode63Grabber[opcode & 0x7FF];
+    default:
+        return OpcodeGrabber[opcode >> 26];
+    }
+}
+
+PPCOpcode ppc_decode_opcode(uint32_t opcode)
+{
+#ifdef PPC_THREADED_DISPATCH
+    return FlatOpcodeGrabber[flat_opcode_index(opcode)];
+#else
+    return ppc_resolve_opcode(opcode);
+#endif
+}
+
+/* Dispatch a predecoded instruction, decode it first if necessary */
+static inline void ppc_exec_slot(DecodedInstr* slot, const uint8_t* pc_real)
+{
+    if (!slot->handler)
+        decode_cache_fill(slot, pc_real);
+
+    ppc_cur_instruction = slot->opcode;
+    ppc_profile_instr();
+    slot->handler();
+}
+
+// current run of the interpreter loops, set up before its first instruction
+static DecodedInstr* exec_dc_page;  // decode cache slots of the current page
+static uint32_t      exec_run_last; // address of the last instruction of the run
+
+/* Superinstructions: frequent pairs of adjacent instructions are given
+   a single slot handler that executes both of them. The second half runs
+   exactly like a separately dispatched instruction: it is skipped if the
+   first one changed the control flow, raised an exception or ended the
+   current run, otherwise ppc_state.pc is advanced to it before it executes.
+   The fused handler leaves ppc_state.pc at the last executed instruction. */
+template <PPCOpcode first, PPCOpcode second>
+static void ppc_exec_fused()
+{
+    first();
+    if (exec_flags || ppc_state.pc == exec_run_last)
+        return;
+
+    ppc_state.pc += 4;
+    ppc_cur_instruction = exec_dc_page[(ppc_state.pc & ~PPC_PAGE_MASK) >> 2].opcode;
+    ppc_profile_instr();
+    second();
+}
+
+typedef struct FusedPair {
+    PPCOpcode first;
+    PPCOpcode second;
+    PPCOpcode fused;
+} FusedPair;
+
+template <PPCOpcode first, PPCOpcode second>
+static constexpr FusedPair fused_pair() {
+    return {first, second, ppc_exec_fused<first, second>};
+}
+
+// The first instruction of a pair must not write to memory because the
+// second one is taken from the decode cache without checking it again.
+static const FusedPair FusedPairs[] = {
+    fused_pair<ppc_cmpi, ppc_bc<LK0, AA0>>(),           // cmpwi  + bc
+    fused_pair<ppc_cmpli, ppc_bc<LK0, AA0>>(),          // cmplwi + bc
+    fused_pair<ppc_cmp, ppc_bc<LK0, AA0>>(),            // cmpw   + bc
+    fused_pair<ppc_cmpl, ppc_bc<LK0, AA0>>(),           // cmplw  + bc
+    fused_pair<ppc_addi<SHFT1>, ppc_ori<SHFT0>>(),      // lis    + ori
+    fused_pair<ppc_addi<SHFT1>, ppc_addi<SHFT0>>(),     // lis    + addi
+    fused_pair<ppc_lz<uint32_t>, ppc_addi<SHFT0>>(),    // lwz    + addi
+    fused_pair<ppc_mfspr, ppc_st<uint32_t>>(),          // mflr   + stw
+    fused_pair<ppc_rlwinm, ppc_lzx<uint32_t>>(),        // rlwinm + lwzx
+};
+
+PPCOpcode ppc_fuse_opcodes(uint32_t first, uint32_t second)
+{
+    PPCOpcode first_handler  = ppc_decode_opcode(first);
+    PPCOpcode second_handler = ppc_decode_opcode(second);
+
+    for (const FusedPair& pair : FusedPairs) {
+        if (pair.first == first_handler && pair.second == second_handler)
+            return pair.fused;
+    }
+    return nullptr;
 }
 
 long long now_ns() {
@@ -339,125 +454,210 @@ long long now_ns() {
 uint64_t get_virt_time_ns()
 {
     if (g_realtime) {
-        return now_ns() - g_nanoseconds_base;
+        return g_virt_ns_base + (((g_icycles - g_icycles_base) * g_ns_per_cycle) >> RT_RATE_SHIFT);
     } else {
         return g_icycles << icnt_factor;
     }
 }
 
+static void realtime_reset()
+{
+    g_nanoseconds_base = now_ns();
+    g_virt_ns_base     = 0;
+    g_icycles_base     = g_icycles;
+    g_ns_per_cycle     = 1ULL << (RT_RATE_SHIFT + icnt_factor);
+
+    rt_window_start   = 0;
+    rt_window_icycles = g_icycles;
+    rt_window_skipped = idle_cycles_skipped;
+    rt_window_slept   = 0;
+}
+
+/** Keep virtual time in step with the host's wall clock. */
+static void realtime_pace()
+{
+    uint64_t host_ns = now_ns() - g_nanoseconds_base;
+    uint64_t virt_ns = get_virt_time_ns();
+
+    if (host_ns - rt_window_start >= RT_CALIBRATE_NS) {
+        // host time per executed instruction, not counting sleeps and idle skips
+        uint64_t busy_ns = host_ns - rt_window_start - rt_window_slept;
+        uint64_t cycles  = (g_icycles - rt_window_icycles) -
+                           (idle_cycles_skipped - rt_window_skipped);
+        // windows spent mostly waiting say little about the execution speed
+        if (cycles && busy_ns >= RT_CALIBRATE_NS / 2) {
+            uint64_t rate = (busy_ns << RT_RATE_SHIFT) / cycles;
+            rate = (g_ns_per_cycle + rate) >> 1; // smooth out hiccups
+            g_ns_per_cycle = std::clamp(rate, RT_RATE_MIN, RT_RATE_MAX);
+        }
+
+        // start a new segment so virtual time doesn't jump when the rate
+        // changes, and so the product in get_virt_time_ns() can't overflow
+        // in a long-running segment, even if the rate stays the same
+        g_virt_ns_base = virt_ns;
+        g_icycles_base = g_icycles;
+
+        rt_window_start   = host_ns;
+        rt_window_icycles = g_icycles;
+        rt_window_skipped = idle_cycles_skipped;
+        rt_window_slept   = 0;
+    }
+
+    if (virt_ns >= host_ns + RT_MIN_SLEEP_NS) {
+        // the guest is ahead, typically after skipping an idle loop up to the
+        // next timer: wait for the wall clock instead of spinning, but wake up
+        // when another thread posts an event
+        std::unique_lock<std::mutex> lk(rt_mtx);
+        rt_cv.wait_for(lk, std::chrono::nanoseconds(std::min(virt_ns - host_ns, RT_MAX_SLEEP_NS)),
+                       [] { return events_pending.load(); });
+        rt_window_slept += (now_ns() - g_nanoseconds_base) - host_ns;
+    } else if (host_ns > virt_ns + RT_MAX_LAG_NS) {
+        // too far behind, e.g. after a stop in the debugger: don't rush
+        // through all the timers that should have fired meanwhile
+        g_nanoseconds_base += host_ns - virt_ns;
+        rt_window_start    -= host_ns - virt_ns;
+    }
+}
+
 uint64_t process_events()
 {
-    exec_timer = false;
+    // clear before looking at the timer queue so that changes made
+    // concurrently by other threads aren't lost
+    events_pending.store(false);
+#ifdef CPU_PROFILING
+    num_event_checks++;
+#endif
+    if (g_realtime)
+        realtime_pace();
     uint64_t slice_ns = TimerManager::get_instance()->process_timers();
+    idle_events_seen  = true;
     if (slice_ns == 0) {
-        // execute 10.000 cycles
-        // if there are no pending timers
-        return g_icycles + 10000;
+        // no pending timers: run until one gets added, adding
+        // a timer sets events_pending
+        return UINT64_MAX;
     }
-    return g_icycles + ((slice_ns + (1ULL << icnt_factor)) >> icnt_factor);
+    // first cycle at or past the deadline
+    if (g_realtime)
+        return g_icycles + ((slice_ns << RT_RATE_SHIFT) + g_ns_per_cycle - 1) / g_ns_per_cycle;
+    return g_icycles + ((slice_ns + (1ULL << icnt_factor) - 1) >> icnt_factor);
 }
 
 void force_cycle_counter_reload()
 {
     // tell the interpreter loop to reload cycle counter
-    exec_timer = true;
+    events_pending.store(true, std::memory_order_release);
+
+    if (g_realtime) {
+        // wake up the execution loop if it's waiting for the wall clock
+        { std::lock_guard<std::mutex> lk(rt_mtx); }
+        rt_cv.notify_one();
+    }
 }
 
-/** Execute PPC code as long as power is on. */
-// inner interpreter loop
-static void ppc_exec_inner()
+static inline bool ppc_events_due(uint64_t next_event)
 {
-    uint64_t max_cycles;
-    uint32_t page_start, eb_start, eb_end;
-    uint8_t* pc_real;
-
-    max_cycles = 0;
-
-    while (power_on) {
-        // define boundaries of the next execution block
-        // max execution block length = one memory page
-        eb_start   = ppc_state.pc;
-        page_start = eb_start & PPC_PAGE_MASK;
-        eb_end     = page_start + PPC_PAGE_SIZE - 1;
-        exec_flags = 0;
-
-        pc_real    = mmu_translate_imem(eb_start);
+    return g_icycles >= next_event || events_pending.load(std::memory_order_acquire);
+}
 
-        // interpret execution block
-        while (power_on && ppc_state.pc < eb_end) {
-            ppc_main_opcode();
-            if (g_icycles++ >= max_cycles || exec_timer) {
-                max_cycles = process_events();
-            }
+// stop address for loops that run as long as power is on
+// (never reached because the PC is always word-aligned)
+constexpr uint32_t NO_GOAL_ADDR = 0xFFFFFFFFUL;
 
-            if (exec_flags) {
-                // define next execution block
-                eb_start = ppc_next_instruction_address;
-                if (!(exec_flags & EXEF_RFI) && (eb_start & PPC_PAGE_MASK) == page_start) {
-                    pc_real += (int)eb_start - (int)ppc_state.pc;
-                    ppc_set_cur_instruction(pc_real);
-                } else {
-                    page_start = eb_start & PPC_PAGE_MASK;
-                    eb_end = page_start + PPC_PAGE_SIZE - 1;
-                    pc_real = mmu_translate_imem(eb_start);
-                }
-                ppc_state.pc = eb_start;
-                exec_flags = 0;
-            } else {
-                ppc_state.pc += 4;
-                pc_real += 4;
-                ppc_set_cur_instruction(pc_real);
-            }
-        }
-    }
+/** Number of instructions that may run from pc without checking for events:
+    up to the end of the page, but neither past next_event nor stop_addr. */
+static inline uint32_t ppc_run_budget(uint32_t pc, uint64_t next_event, uint32_t stop_addr)
+{
+    uint64_t budget = (PPC_PAGE_SIZE - (pc & ~PPC_PAGE_MASK)) >> 2;
+
+    if (next_event <= g_icycles)
+        return 1;
+    budget = std::min(budget, next_event - g_icycles);
+    if (stop_addr > pc)
+        budget = std::min(budget, (uint64_t(stop_addr) - pc + 3) >> 2);
+    return uint32_t(budget);
 }
 
-// outer interpreter loop
-void ppc_exec()
+/** Interpret instructions from ppc_state.pc up to run_last or the first one
+    setting exec_flags. dc_page and page_real are the decode cache slots and
+    the host address of the current page. Leaves ppc_state.pc pointing to the
+    last executed instruction and charges the whole run to g_icycles. */
+static inline void ppc_exec_run(uint32_t run_last, DecodedInstr* dc_page, const uint8_t* page_real)
 {
-    if (setjmp(exc_env)) {
-        // process low-level exceptions
-        //LOG_F(9, "PPC-EXEC: low_level exception raised!");
-        ppc_state.pc = ppc_next_instruction_address;
+    uint32_t run_start = ppc_state.pc;
+    uint32_t offset    = run_start & ~PPC_PAGE_MASK;
+    DecodedInstr* dc_slot = &dc_page[offset >> 2];
+    const uint8_t* pc_real = page_real + offset;
+
+    exec_dc_page  = dc_page;
+    exec_run_last = run_last;
+
+    while (1) {
+        ppc_exec_slot(dc_slot, pc_real);
+        if (exec_flags || ppc_state.pc == run_last)
+            break;
+        // a fused slot that didn't end the run has executed both instructions
+        if (dc_slot->flags & DC_FLAG_FUSED) {
+            dc_slot++;
+            pc_real += 4;
+        }
+        ppc_state.pc += 4;
+        pc_real += 4;
+        dc_slot++;
     }
 
-    while (power_on) {
-        ppc_exec_inner();
-    }
+    g_icycles += ((ppc_state.pc - run_start) >> 2) + 1;
 }
 
-/** Execute one PPC instruction. */
-void ppc_exec_single()
-{
-    if (setjmp(exc_env)) {
-        // process low-level exceptions
-        //LOG_F(9, "PPC-EXEC: low_level exception raised!");
-        ppc_state.pc = ppc_next_instruction_address;
-        exec_flags = 0;
-        return;
-    }
+/* Stop policies for the interpreter loops. reached() is checked after each
+   run of instructions, next_stop() tells the lowest address above pc the
+   next run must not go past. */
 
-    mmu_translate_imem(ppc_state.pc);
-    ppc_main_opcode();
-    g_icycles++;
-    process_events();
+// run as long as power is on
+struct StopNever {
+    bool     reached(uint32_t) const { return false; }
+    uint32_t next_stop(uint32_t) const { return NO_GOAL_ADDR; }
+};
 
-    if (exec_flags) {
-        ppc_state.pc = ppc_next_instruction_address;
-        exec_flags = 0;
-    } else {
-        ppc_state.pc += 4;
-    }
-}
+// stop at goal_addr
+struct StopAtAddr {
+    uint32_t goal_addr;
 
-/** Execute PPC code until goal_addr is reached. */
+    bool     reached(uint32_t pc) const { return pc == goal_addr; }
+    uint32_t next_stop(uint32_t) const { return goal_addr; }
+};
+
+// stop on entering the range [start_addr, start_addr + size)
+struct StopInRange {
+    uint32_t start_addr;
+    uint32_t size;
 
+    bool     reached(uint32_t pc) const { return pc - start_addr < size; }
+    uint32_t next_stop(uint32_t) const { return start_addr; }
+};
+
+// stop at any of the breakpoint addresses
+struct StopAtBreakpoints {
+    const std::set<uint32_t>& addrs;
+
+    bool reached(uint32_t pc) const { return addrs.count(pc); }
+    uint32_t next_stop(uint32_t pc) const {
+        auto it = addrs.upper_bound(pc);
+        return it == addrs.end() ? NO_GOAL_ADDR : *it;
+    }
+};
+
+#ifndef PPC_COMPUTED_GOTO
+/** Execute PPC code until stop is reached or power goes off.
+    Always executes at least one instruction. */
 // inner interpreter loop
-static void ppc_exec_until_inner(const uint32_t goal_addr)
+template <class StopPolicy>
+static void ppc_exec_inner(const StopPolicy& stop)
 {
     uint64_t max_cycles;
-    uint32_t page_start, eb_start, eb_end;
+    uint32_t page_start, eb_start, eb_end, eb_phys, run_len;
     uint8_t* pc_real;
+    uint8_t* page_real;
+    DecodedInstr* dc_page;
 
     max_cycles = 0;
 
@@ -469,119 +669,300 @@ static void ppc_exec_until_inner(const uint32_t goal_addr)
         eb_end     = page_start + PPC_PAGE_SIZE - 1;
         exec_flags = 0;
 
-        pc_real    = mmu_translate_imem(eb_start);
+        pc_real    = mmu_translate_imem(eb_start, &eb_phys);
+        if (!pc_real) {
+            // instruction fetch caused an ISI exception
+            ppc_state.pc = ppc_next_instruction_address;
+            continue;
+        }
+        page_real  = pc_real - (eb_start & ~PPC_PAGE_MASK);
+        dc_page    = decode_cache_get_page(eb_phys);
 
         // interpret execution block
-        while (power_on && ppc_state.pc < eb_end) {
-            ppc_main_opcode();
-            if (g_icycles++ >= max_cycles || exec_timer) {
+        while (ppc_state.pc < eb_end) {
+            run_len = ppc_run_budget(ppc_state.pc, max_cycles, stop.next_stop(ppc_state.pc));
+            ppc_exec_run(ppc_state.pc + (run_len - 1) * 4, dc_page, page_real);
+            if (ppc_events_due(max_cycles)) {
                 max_cycles = process_events();
             }
 
             if (exec_flags) {
                 // define next execution block
                 eb_start = ppc_next_instruction_address;
-                if (!(exec_flags & EXEF_RFI) && (eb_start & PPC_PAGE_MASK) == page_start) {
-                    pc_real += (int)eb_start - (int)ppc_state.pc;
-                    ppc_set_cur_instruction(pc_real);
-                } else {
-                    page_start = eb_start & PPC_PAGE_MASK;
-                    eb_end = page_start + PPC_PAGE_SIZE - 1;
-                    pc_real = mmu_translate_imem(eb_start);
+                if ((exec_flags & (EXEF_RFI | EXEF_EXCEPTION)) ||
+                    (eb_start & PPC_PAGE_MASK) != page_start) {
+                    // the new block needs a fresh translation
+                    ppc_state.pc = eb_start;
+                    break;
                 }
+                ppc_idle_check(ppc_state.pc, &dc_page[(ppc_state.pc & ~PPC_PAGE_MASK) >> 2],
+                               eb_start, page_real + (eb_start & ~PPC_PAGE_MASK), max_cycles);
                 ppc_state.pc = eb_start;
                 exec_flags = 0;
             } else {
                 ppc_state.pc += 4;
-                pc_real += 4;
-                ppc_set_cur_instruction(pc_real);
             }
 
-            if (ppc_state.pc == goal_addr)
-                break;
+            if (stop.reached(ppc_state.pc) || !power_on)
+                return;
         }
-    } while (power_on && ppc_state.pc != goal_addr);
+    } while (power_on && !stop.reached(ppc_state.pc));
 }
+#endif
 
-// outer interpreter loop
-void ppc_exec_until(volatile uint32_t goal_addr)
+#ifdef PPC_COMPUTED_GOTO
+
+/** Threaded variant of the inner interpreter loops.
+    Every primary opcode gets its own copy of the instruction epilogue
+    and dispatch jump so the host branch predictor can learn successors
+    per opcode instead of sharing a single indirect branch. */
+template <class StopPolicy>
+PPC_NO_CROSSJUMPING static void ppc_exec_threaded_inner(const StopPolicy& stop)
 {
-    if (setjmp(exc_env)) {
-        // process low-level exceptions
-        //LOG_F(9, "PPC-EXEC: low_level exception raised!");
-        ppc_state.pc = ppc_next_instruction_address;
+#define OP_LABELS8(n) &&op_##n##0, &&op_##n##1, &&op_##n##2, &&op_##n##3, \
+                      &&op_##n##4, &&op_##n##5, &&op_##n##6, &&op_##n##7
+    static const void* const dispatch_tbl[64] = {
+        OP_LABELS8(0), OP_LABELS8(1), OP_LABELS8(2), OP_LABELS8(3),
+        OP_LABELS8(4), OP_LABELS8(5), OP_LABELS8(6), OP_LABELS8(7)
+    };
+
+    uint64_t max_cycles;
+    uint32_t page_start, eb_start, eb_phys, run_start, run_last;
+    uint8_t* page_real;
+    DecodedInstr *dc_page, *dc_slot;
+
+#define DISPATCH() \
+    do { \
+        if (!dc_slot->handler) \
+            decode_cache_fill(dc_slot, page_real + (ppc_state.pc & ~PPC_PAGE_MASK)); \
+        ppc_cur_instruction = dc_slot->opcode; \
+        goto *dispatch_tbl[ppc_cur_instruction >> 26]; \
+    } while (0)
+
+#define OP_BODY(n) \
+    op_##n: \
+        ppc_profile_instr(); \
+        dc_slot->handler(); \
+        if (exec_flags || ppc_state.pc == run_last) \
+            goto end_run; \
+        if (__builtin_expect(dc_slot->flags & DC_FLAG_FUSED, 0)) \
+            goto after_fused; \
+        ppc_state.pc += 4; \
+        dc_slot++; \
+        DISPATCH();
+
+#define START_RUN() \
+    do { \
+        run_start = ppc_state.pc; \
+        run_last  = run_start + (ppc_run_budget(run_start, max_cycles, stop.next_stop(run_start)) - 1) * 4; \
+        exec_run_last = run_last; \
+    } while (0)
+
+#define OP_BODIES8(n) OP_BODY(n##0) OP_BODY(n##1) OP_BODY(n##2) OP_BODY(n##3) \
+                      OP_BODY(n##4) OP_BODY(n##5) OP_BODY(n##6) OP_BODY(n##7)
+
+    max_cycles = 0;
+    exec_flags = 0;
+    goto start;
+
+    OP_BODIES8(0) OP_BODIES8(1) OP_BODIES8(2) OP_BODIES8(3)
+    OP_BODIES8(4) OP_BODIES8(5) OP_BODIES8(6) OP_BODIES8(7)
+
+after_fused:
+    // a fused slot that didn't end the run has executed both instructions
+    ppc_state.pc += 4;
+    dc_slot += 2;
+    DISPATCH();
+
+end_run:
+    g_icycles += ((ppc_state.pc - run_start) >> 2) + 1;
+    if (ppc_events_due(max_cycles))
+        max_cycles = process_events();
+    if (!exec_flags) {
+        ppc_state.pc += 4;
+        if (!(ppc_state.pc & ~PPC_PAGE_MASK))
+            goto next_page;
+        if (stop.reached(ppc_state.pc) || !power_on)
+            return;
+        dc_slot = &dc_page[(ppc_state.pc & ~PPC_PAGE_MASK) >> 2];
+        START_RUN();
+        DISPATCH();
     }
 
-    do {
-        ppc_exec_until_inner(goal_addr);
-    } while (power_on && ppc_state.pc != goal_addr);
+    eb_start = ppc_next_instruction_address;
+    if (!(exec_flags & (EXEF_RFI | EXEF_EXCEPTION)) && (eb_start & PPC_PAGE_MASK) == page_start) {
+        exec_flags = 0;
+        ppc_idle_check(ppc_state.pc, &dc_page[(ppc_state.pc & ~PPC_PAGE_MASK) >> 2],
+                       eb_start, page_real + (eb_start & ~PPC_PAGE_MASK), max_cycles);
+        dc_slot = &dc_page[(eb_start & ~PPC_PAGE_MASK) >> 2];
+        ppc_state.pc = eb_start;
+        if (stop.reached(ppc_state.pc) || !power_on)
+            return;
+        START_RUN();
+        DISPATCH();
+    }
+    exec_flags   = 0;
+    ppc_state.pc = eb_start;
+
+next_page:
+    if (stop.reached(ppc_state.pc) || !power_on)
+        return;
+
+start:
+    page_start = ppc_state.pc & PPC_PAGE_MASK;
+    page_real  = mmu_translate_imem(ppc_state.pc, &eb_phys);
+    if (!page_real) {
+        // instruction fetch caused an ISI exception
+        ppc_state.pc = ppc_next_instruction_address;
+        exec_flags   = 0;
+        goto next_page;
+    }
+    page_real   -= ppc_state.pc & ~PPC_PAGE_MASK;
+    dc_page      = decode_cache_get_page(eb_phys);
+    dc_slot      = &dc_page[(ppc_state.pc & ~PPC_PAGE_MASK) >> 2];
+    exec_dc_page = dc_page;
+    START_RUN();
+    DISPATCH();
+
+#undef OP_BODIES8
+#undef START_RUN
+#undef OP_BODY
+#undef DISPATCH
+#undef OP_LABELS8
 }
 
-/** Execute PPC code until control is reached the specified region. */
+#endif // PPC_COMPUTED_GOTO
 
-// inner interpreter loop
-static void ppc_exec_dbg_inner(const uint32_t start_addr, const uint32_t size)
+template <class StopPolicy>
+static inline void ppc_exec_interp(const StopPolicy& stop)
 {
-    uint64_t max_cycles;
-    uint32_t page_start, eb_start, eb_end;
+#ifdef PPC_COMPUTED_GOTO
+    ppc_exec_threaded_inner(stop);
+#else
+    ppc_exec_inner(stop);
+#endif
+}
+
+/** Execute PPC code using translated blocks where available. */
+static void ppc_exec_jit_inner()
+{
+    uint32_t eb_phys;
     uint8_t* pc_real;
+    uint8_t* page_real;
+    DecodedInstr* dc_page;
+    JitCode code;
 
-    max_cycles = 0;
+    jit_cycle_limit = 0;
 
-    while (power_on && (ppc_state.pc < start_addr || ppc_state.pc >= start_addr + size)) {
-        // define boundaries of the next execution block
-        // max execution block length = one memory page
-        eb_start   = ppc_state.pc;
-        page_start = eb_start & PPC_PAGE_MASK;
-        eb_end     = page_start + PPC_PAGE_SIZE - 1;
+    while (power_on) {
         exec_flags = 0;
 
-        pc_real    = mmu_translate_imem(eb_start);
+        pc_real = mmu_translate_imem(ppc_state.pc, &eb_phys);
+        if (!pc_real) {
+            // instruction fetch caused an ISI exception
+            ppc_state.pc = ppc_next_instruction_address;
+            continue;
+        }
+        code    = ppc_jit_lookup(ppc_state.pc, eb_phys, pc_real);
 
-        // interpret execution block
-        while (power_on && (ppc_state.pc < start_addr || ppc_state.pc >= start_addr + size)
-                && (ppc_state.pc < eb_end)) {
-            ppc_main_opcode();
-            if (g_icycles++ >= max_cycles || exec_timer) {
-                max_cycles = process_events();
+        if (code) {
+#ifdef CPU_PROFILING
+            uint64_t start_cycles = g_icycles;
+#endif
+            jit_block_stale = false;
+            ppc_cr_sync();
+            code();
+#ifdef CPU_PROFILING
+            num_executed_instrs += g_icycles - start_cycles;
+#endif
+            if (ppc_events_due(jit_cycle_limit)) {
+                jit_cycle_limit = process_events();
+            }
+        } else {
+            // interpret cold code up to the next branch or page end
+            dc_page   = decode_cache_get_page(eb_phys);
+            page_real = pc_real - (ppc_state.pc & ~PPC_PAGE_MASK);
+
+            ppc_exec_run(ppc_state.pc + (ppc_run_budget(ppc_state.pc, jit_cycle_limit, NO_GOAL_ADDR) - 1) * 4,
+                         dc_page, page_real);
+            if (ppc_events_due(jit_cycle_limit)) {
+                jit_cycle_limit = process_events();
             }
 
-            if (exec_flags) {
-                // define next execution block
-                eb_start = ppc_next_instruction_address;
-                if (!(exec_flags & EXEF_RFI) && (eb_start & PPC_PAGE_MASK) == page_start) {
-                    pc_real += (int)eb_start - (int)ppc_state.pc;
-                    ppc_set_cur_instruction(pc_real);
-                } else {
-                    page_start = eb_start & PPC_PAGE_MASK;
-                    eb_end = page_start + PPC_PAGE_SIZE - 1;
-                    pc_real = mmu_translate_imem(eb_start);
-                }
-                ppc_state.pc = eb_start;
-                exec_flags = 0;
-            } else {
-                ppc_state.pc += 4;
-                pc_real += 4;
-                ppc_set_cur_instruction(pc_real);
+            uint32_t target = ppc_next_instruction_address;
+            if (exec_flags && !(exec_flags & (EXEF_RFI | EXEF_EXCEPTION)) &&
+                (target & PPC_PAGE_MASK) == (ppc_state.pc & PPC_PAGE_MASK)) {
+                ppc_idle_check(ppc_state.pc, &dc_page[(ppc_state.pc & ~PPC_PAGE_MASK) >> 2], target,
+                               page_real + (target & ~PPC_PAGE_MASK), jit_cycle_limit);
             }
         }
+
+        // ppc_state.pc points to the last executed instruction
+        if (exec_flags) {
+            ppc_state.pc = ppc_next_instruction_address;
+            exec_flags = 0;
+        } else {
+            ppc_state.pc += 4;
+        }
     }
 }
 
 // outer interpreter loop
-void ppc_exec_dbg(volatile uint32_t start_addr, volatile uint32_t size)
+void ppc_exec()
 {
-    if (setjmp(exc_env)) {
-        // process low-level exceptions
-        //LOG_F(9, "PPC-EXEC: low_level exception raised!");
+    while (power_on) {
+        if (jit_enabled)
+            ppc_exec_jit_inner();
+        else
+            ppc_exec_interp(StopNever());
+    }
+}
+
+/** Execute one PPC instruction. */
+void ppc_exec_single()
+{
+    exec_flags = 0;
+
+    if (!mmu_translate_imem(ppc_state.pc)) {
+        // instruction fetch caused an ISI exception
         ppc_state.pc = ppc_next_instruction_address;
+        exec_flags = 0;
+        return;
     }
 
-    while (power_on && (ppc_state.pc < start_addr || ppc_state.pc >= start_addr + size)) {
-        ppc_exec_dbg_inner(start_addr, size);
+    ppc_main_opcode();
+    g_icycles++;
+    process_events();
+
+    if (exec_flags) {
+        ppc_state.pc = ppc_next_instruction_address;
+        exec_flags = 0;
+    } else {
+        ppc_state.pc += 4;
     }
 }
 
+/** Execute PPC code until goal_addr is reached. */
+void ppc_exec_until(uint32_t goal_addr)
+{
+    ppc_exec_interp(StopAtAddr{goal_addr});
+}
+
+/** Execute PPC code until any of goal_addrs is reached. */
+void ppc_exec_until(const std::set<uint32_t>& goal_addrs)
+{
+    ppc_exec_interp(StopAtBreakpoints{goal_addrs});
+}
+
+/** Execute PPC code until control is reached the specified region. */
+void ppc_exec_dbg(uint32_t start_addr, uint32_t size)
+{
+    StopInRange stop{start_addr, size};
+
+    if (power_on && !stop.reached(ppc_state.pc))
+        ppc_exec_interp(stop);
+}
+
 /*
 Opcode table macros:
 - d is for dot (RC).
@@ -628,6 +1009,8 @@ do { \
     opcode ## Grabber[1024+((subopcode)<<1)+1] = fn<carry, RC1, OV1>; \
 } while (0)
 
+#define OP19(subopcode, fn) OPX(SubOpcode19, subopcode, fn)
+
 #define OP31(subopcode, fn) OPX(SubOpcode31, subopcode, fn)
 #define OP31d(subopcode, fn) OPXd(SubOpcode31, subopcode, fn)
 #define OP31od(subopcode, fn) OPXod(SubOpcode31, subopcode, fn)
@@ -656,7 +1039,7 @@ void initialize_ppc_opcode_tables(bool include_601) {
     OP(16, ppc_opcode16);
     OP(17, ppc_sc);
     OP(18, ppc_opcode18);
-    if (is_601) OP(19, ppc_opcode19<IS601>); else OP(19, ppc_opcode19<NOT601>);
+    OP(19, ppc_opcode19);
     OP(20, ppc_rlwimi);
     OP(21, ppc_rlwinm);
     if (is_601 || include_601) OP(22, power_rlmi);
@@ -695,6 +1078,28 @@ void initialize_ppc_opcode_tables(bool include_601) {
     OP(59, ppc_opcode59);
     OP(63, ppc_opcode63);
 
+    std::fill_n(SubOpcode19Grabber, 2048, ppc_illegalop);
+    OP19(0,      ppc_mcrf);
+    SubOpcode19Grabber[32] = ppc_bclr<LK0>;
+    SubOpcode19Grabber[33] = ppc_bclr<LK1>;
+    OP19(33,     ppc_crnor);
+    OP19(50,     ppc_rfi);
+    OP19(129,    ppc_crandc);
+    OP19(150,    ppc_isync);
+    OP19(193,    ppc_crxor);
+    OP19(225,    ppc_crnand);
+    OP19(257,    ppc_crand);
+    OP19(289,    ppc_creqv);
+    OP19(417,    ppc_crorc);
+    OP19(449,    ppc_cror);
+    if (is_601) {
+        SubOpcode19Grabber[1056] = ppc_bcctr<LK0, IS601>;
+        SubOpcode19Grabber[1057] = ppc_bcctr<LK1, IS601>;
+    } else {
+        SubOpcode19Grabber[1056] = ppc_bcctr<LK0, NOT601>;
+        SubOpcode19Grabber[1057] = ppc_bcctr<LK1, NOT601>;
+    }
+
     std::fill_n(SubOpcode31Grabber, 2048, ppc_illegalop);
     OP31(0,      ppc_cmp);
     OP31(4,      ppc_tw);
@@ -874,6 +1279,14 @@ void initialize_ppc_opcode_tables(bool include_601) {
         OP63d(i + 30, ppc_fnmsub);
         OP63d(i + 31, ppc_fnmadd);
     }
+
+#ifdef PPC_THREADED_DISPATCH
+    for (uint32_t i = 0; i < 64 * 2048; i++)
+        FlatOpcodeGrabber[i] = ppc_resolve_opcode(((i & 0x1F800) << 15) | (i & 0x7FF));
+#endif
+
+    // predecoded instructions may refer to stale handlers
+    decode_cache_flush();
 }
 
 void ppc_cpu_init(MemCtrlBase* mem_ctrl, uint32_t cpu_version, bool include_601, uint64_t tb_freq)
@@ -883,6 +1296,7 @@ void ppc_cpu_init(MemCtrlBase* mem_ctrl, uint32_t cpu_version, bool include_601,
     mem_ctrl_instance = mem_ctrl;
 
     std::memset(&ppc_state, 0, sizeof(ppc_state));
+    ppc_cr_set(0);
     set_host_rounding_mode(0);
 
     ppc_state.spr[SPR::PVR] = cpu_version;
@@ -893,16 +1307,18 @@ void ppc_cpu_init(MemCtrlBase* mem_ctrl, uint32_t cpu_version, bool include_601,
     // initialize emulator timers
     TimerManager::get_instance()->set_time_now_cb(&get_virt_time_ns);
     TimerManager::get_instance()->set_notify_changes_cb(&force_cycle_counter_reload);
+#ifdef TIMER_PROFILING
+    TimerManager::get_instance()->register_profile();
+#endif
 
     // initialize time base facility
 #ifdef __APPLE__
     mach_timebase_info(&timebase_info);
 #endif
-    g_nanoseconds_base = now_ns();
-    g_icycles_base = 0;
     g_icycles = 0;
     //icnt_factor      = 6;
     icnt_factor = 4;
+    realtime_reset();
     tbr_wr_timestamp = 0;
     rtc_timestamp = 0;
     tbr_wr_value = 0;
@@ -910,7 +1326,7 @@ void ppc_cpu_init(MemCtrlBase* mem_ctrl, uint32_t cpu_version, bool include_601,
     tbr_period_ns = ((uint64_t)NS_PER_SEC << 32) / tb_freq;
 
     exec_flags = 0;
-    exec_timer = false;
+    events_pending = false;
 
     timebase_counter = 0;
     dec_wr_value = 0;
@@ -970,6 +1386,9 @@ uint64_t reg_op(string& reg_name, uint64_t val, bool is_write) {
 
     reg_name_u = reg_name;
 
+    // CR and XER[SO] must be up to date before reading or changing them
+    ppc_cr_sync();
+
     /* convert reg_name string to uppercase */
     std::for_each(reg_name_u.begin(), reg_name_u.end(), [](char& c) {
         c = ::toupper(c);
@@ -988,7 +1407,7 @@ uint64_t reg_op(string& reg_name, uint64_t val, bool is_write) {
         }
         if (reg_name_u == "CR") {
             if (is_write)
-                ppc_state.cr = (uint32_t)val;
+                ppc_cr_set((uint32_t)val);
             return ppc_state.cr;
         }
         if (reg_name_u == "FPSCR") {
@@ -1050,8 +1469,10 @@ uint64_t reg_op(string& reg_name, uint64_t val, bool is_write) {
             reg_num_str = reg_name_u.substr(2);
             reg_num     = (unsigned)stoul(reg_num_str, NULL, 0);
             if (reg_num < 16) {
-                if (is_write)
+                if (is_write) {
                     ppc_state.sr[reg_num] = (uint32_t)val;
+                    mmu_sr_changed(reg_num);
+                }
                 return ppc_state.sr[reg_num];
             }
         }
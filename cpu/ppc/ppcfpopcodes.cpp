@@ -42,6 +42,7 @@ uint64_t fp_return_uint64(uint32_t reg) {
 
 inline static void ppc_update_cr1() {
     // copy FPSCR[FX|FEX|VX|OX] to CR1
+    ppc_cr_sync();
     ppc_state.cr = (ppc_state.cr & ~CR_select::CR1_field) |
                    ((ppc_state.fpscr >> 4) & CR_select::CR1_field);
 }
@@ -667,6 +668,8 @@ void dppc_interpreter::ppc_lfs() {
     ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
     ppc_effective_address += (reg_a) ? val_reg_a : 0;
     uint32_t result = mmu_read_vmem<uint32_t>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
     ppc_state.fpr[reg_d].dbl64_r = *(float*)(&result);
 }
 
@@ -676,6 +679,8 @@ void dppc_interpreter::ppc_lfsu() {
         ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
         ppc_effective_address += (reg_a) ? val_reg_a : 0;
         uint32_t result = mmu_read_vmem<uint32_t>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
         ppc_state.fpr[reg_d].dbl64_r = *(float*)(&result);
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
@@ -687,6 +692,8 @@ void dppc_interpreter::ppc_lfsx() {
     ppc_grab_regsfpdiab(ppc_cur_instruction);
     ppc_effective_address = val_reg_b + (reg_a ? val_reg_a : 0);
     uint32_t result       = mmu_read_vmem<uint32_t>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
     ppc_state.fpr[reg_d].dbl64_r = *(float*)(&result);
 }
 
@@ -695,6 +702,8 @@ void dppc_interpreter::ppc_lfsux() {
     if (reg_a) {
         ppc_effective_address = val_reg_a + val_reg_b;
         uint32_t result = mmu_read_vmem<uint32_t>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
         ppc_state.fpr[reg_d].dbl64_r = *(float*)(&result);
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
@@ -707,6 +716,8 @@ void dppc_interpreter::ppc_lfd() {
     ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
     ppc_effective_address += (reg_a) ? val_reg_a : 0;
     uint64_t ppc_result64_d = mmu_read_vmem<uint64_t>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
     ppc_store_dfpresult_int(reg_d, ppc_result64_d);
 }
 
@@ -716,6 +727,8 @@ void dppc_interpreter::ppc_lfdu() {
         ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
         ppc_effective_address += val_reg_a;
         uint64_t ppc_result64_d = mmu_read_vmem<uint64_t>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
         ppc_store_dfpresult_int(reg_d, ppc_result64_d);
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
@@ -727,6 +740,8 @@ void dppc_interpreter::ppc_lfdx() {
     ppc_grab_regsfpdiab(ppc_cur_instruction);
     ppc_effective_address   = val_reg_b + (reg_a ? val_reg_a : 0);
     uint64_t ppc_result64_d = mmu_read_vmem<uint64_t>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
     ppc_store_dfpresult_int(reg_d, ppc_result64_d);
 }
 
@@ -735,6 +750,8 @@ void dppc_interpreter::ppc_lfdux() {
     if (reg_a) {
         ppc_effective_address = val_reg_a + val_reg_b;
         uint64_t ppc_result64_d = mmu_read_vmem<uint64_t>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
         ppc_store_dfpresult_int(reg_d, ppc_result64_d);
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
@@ -757,6 +774,8 @@ void dppc_interpreter::ppc_stfsu() {
         ppc_effective_address += val_reg_a;
         float result = ppc_state.fpr[reg_s].dbl64_r;
         mmu_write_vmem<uint32_t>(ppc_effective_address, *(uint32_t*)(&result));
+        if (ppc_instr_aborted())
+            return;
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
@@ -776,6 +795,8 @@ void dppc_interpreter::ppc_stfsux() {
         ppc_effective_address = val_reg_a + val_reg_b;
         float result = ppc_state.fpr[reg_s].dbl64_r;
         mmu_write_vmem<uint32_t>(ppc_effective_address, *(uint32_t*)(&result));
+        if (ppc_instr_aborted())
+            return;
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
@@ -795,6 +816,8 @@ void dppc_interpreter::ppc_stfdu() {
         ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
         ppc_effective_address += val_reg_a;
         mmu_write_vmem<uint64_t>(ppc_effective_address, ppc_state.fpr[reg_s].int64_r);
+        if (ppc_instr_aborted())
+            return;
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
@@ -812,6 +835,8 @@ void dppc_interpreter::ppc_stfdux() {
     if (reg_a != 0) {
         ppc_effective_address = val_reg_a + val_reg_b;
         mmu_write_vmem<uint64_t>(ppc_effective_address, ppc_state.fpr[reg_s].int64_r);
+        if (ppc_instr_aborted())
+            return;
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
@@ -939,6 +964,7 @@ template void dppc_interpreter::ppc_mtfsb1<RC1>();
 void dppc_interpreter::ppc_mcrfs() {
     int crf_d = (ppc_cur_instruction >> 21) & 0x1C;
     int crf_s = (ppc_cur_instruction >> 16) & 0x1C;
+    ppc_cr_sync();
     ppc_state.cr = (
         (ppc_state.cr & ~(0xF0000000UL >> crf_d)) |
         (((ppc_state.fpscr << crf_s) & 0xF0000000UL) >> crf_d)
@@ -982,6 +1008,7 @@ void dppc_interpreter::ppc_fcmpo() {
 
     ppc_state.fpscr &= ~VE; //kludge to pass tests
     ppc_state.fpscr = (ppc_state.fpscr & ~FPSCR::FPCC_MASK) | (cmp_c >> 16); // update FPCC
+    ppc_cr_sync();
     ppc_state.cr = ((ppc_state.cr & ~(0xF0000000 >> crf_d)) | (cmp_c >> crf_d));
 
 }
@@ -1009,6 +1036,7 @@ void dppc_interpreter::ppc_fcmpu() {
 
     ppc_state.fpscr &= ~VE; //kludge to pass tests
     ppc_state.fpscr = (ppc_state.fpscr & ~FPSCR::FPCC_MASK) | (cmp_c >> 16); // update FPCC
+    ppc_cr_sync();
     ppc_state.cr    = ((ppc_state.cr & ~(0xF0000000UL >> crf_d)) | (cmp_c >> crf_d));
 
 }
@@ -0,0 +1,290 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Idle loop detection. */
+
+#include <loguru.hpp>
+#include "ppcemu.h"
+#include "ppcidle.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+bool idle_skip_enabled = true;
+bool idle_events_seen  = false;
+
+uint64_t idle_cycles_skipped = 0;
+
+constexpr uint64_t IDLE_SKIP_MAX = 1ULL << 20; // max cycles skipped per iteration
+
+// registers and CR fields an instruction reads and writes
+typedef struct IdleDeps {
+    uint32_t    gpr_rd;
+    uint32_t    gpr_wr;
+    uint8_t     cr_rd;
+    uint8_t     cr_wr;
+} IdleDeps;
+
+static inline uint32_t gpr_bit(uint32_t reg) { return 1U << reg; }
+
+// Collect register dependencies of an instruction that may appear
+// in an idle loop. Returns false for anything with side effects.
+static bool idle_instr_deps(uint32_t opcode, bool is_last, IdleDeps& deps)
+{
+    uint32_t rd = (opcode >> 21) & 31;
+    uint32_t ra = (opcode >> 16) & 31;
+    uint32_t rb = (opcode >> 11) & 31;
+    uint32_t rc = opcode & 1;
+
+    deps = {};
+
+    switch (opcode >> 26) {
+    case 10: // cmpli
+    case 11: // cmpi
+        deps.gpr_rd = gpr_bit(ra);
+        deps.cr_wr  = 0x80 >> (rd >> 2);
+        return true;
+    case 14: // addi
+    case 15: // addis
+    case 32: // lwz
+    case 34: // lbz
+    case 40: // lhz
+    case 42: // lha
+        deps.gpr_rd = ra ? gpr_bit(ra) : 0;
+        deps.gpr_wr = gpr_bit(rd);
+        return true;
+    case 16: // bc
+        if (!(rd & 4) || (opcode & 1)) // CTR decrement or link
+            return false;
+        if (!(rd & 0x10))
+            deps.cr_rd = 0x80 >> (ra >> 2);
+        return true;
+    case 18: // b, only allowed as the loop branch
+        return is_last && !(opcode & 1);
+    case 19:
+        return ((opcode >> 1) & 0x3FF) == 150; // isync
+    case 21: // rlwinm
+    case 24: // ori
+    case 25: // oris
+    case 26: // xori
+    case 27: // xoris
+        deps.gpr_rd = gpr_bit(rd);
+        deps.gpr_wr = gpr_bit(ra);
+        deps.cr_wr  = ((opcode >> 26) == 21 && rc) ? 0x80 : 0;
+        return true;
+    case 28: // andi.
+    case 29: // andis.
+        deps.gpr_rd = gpr_bit(rd);
+        deps.gpr_wr = gpr_bit(ra);
+        deps.cr_wr  = 0x80;
+        return true;
+    case 31:
+        break;
+    default:
+        return false;
+    }
+
+    switch ((opcode >> 1) & 0x3FF) {
+    case 0:   // cmp
+    case 32:  // cmpl
+        deps.gpr_rd = gpr_bit(ra) | gpr_bit(rb);
+        deps.cr_wr  = 0x80 >> (rd >> 2);
+        return true;
+    case 23:  // lwzx
+    case 87:  // lbzx
+    case 279: // lhzx
+    case 343: // lhax
+    case 534: // lwbrx
+    case 790: // lhbrx
+        deps.gpr_rd = (ra ? gpr_bit(ra) : 0) | gpr_bit(rb);
+        deps.gpr_wr = gpr_bit(rd);
+        return true;
+    case 24:  // slw
+    case 28:  // and
+    case 60:  // andc
+    case 124: // nor
+    case 284: // eqv
+    case 316: // xor
+    case 412: // orc
+    case 444: // or
+    case 476: // nand
+    case 536: // srw
+        deps.gpr_rd = gpr_bit(rd) | gpr_bit(rb);
+        deps.gpr_wr = gpr_bit(ra);
+        deps.cr_wr  = rc ? 0x80 : 0;
+        return true;
+    case 26:  // cntlzw
+    case 922: // extsh
+    case 954: // extsb
+        deps.gpr_rd = gpr_bit(rd);
+        deps.gpr_wr = gpr_bit(ra);
+        deps.cr_wr  = rc ? 0x80 : 0;
+        return true;
+    case 40:  // subf
+    case 266: // add
+        if (opcode & 0x400) // OE updates XER
+            return false;
+        deps.gpr_rd = gpr_bit(ra) | gpr_bit(rb);
+        deps.gpr_wr = gpr_bit(rd);
+        deps.cr_wr  = rc ? 0x80 : 0;
+        return true;
+    case 19:  // mfcr
+        deps.cr_rd  = 0xFF;
+        deps.gpr_wr = gpr_bit(rd);
+        return true;
+    case 339: // mfspr
+        switch ((rb << 5) | ra) {
+        case SPR::RTCU_U:
+        case SPR::RTCL_U:
+        case SPR::DEC_S:
+        case SPR::TBL_U:
+        case SPR::TBU_U:
+            deps.gpr_wr = gpr_bit(rd);
+            return true;
+        default:
+            return false;
+        }
+    case 371: // mftb
+        deps.gpr_wr = gpr_bit(rd);
+        return true;
+    case 598: // sync
+    case 854: // eieio
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Check whether the loop [slots, slots + num_instrs) is idle.
+static bool idle_loop_analyze(DecodedInstr* slots, const uint8_t* host_va, uint32_t num_instrs)
+{
+    IdleDeps deps[IDLE_LOOP_MAX_INSTRS];
+    uint32_t gpr_wr_all = 0;
+    uint8_t  cr_wr_all  = 0;
+
+    for (uint32_t i = 0; i < num_instrs; i++) {
+        if (!slots[i].handler)
+            decode_cache_fill(&slots[i], host_va + i * 4);
+        if (!idle_instr_deps(slots[i].opcode, i == num_instrs - 1, deps[i]))
+            return false;
+        gpr_wr_all |= deps[i].gpr_wr;
+        cr_wr_all  |= deps[i].cr_wr;
+    }
+
+    // nothing written by the loop may be read before being written
+    // in the same iteration, otherwise iterations aren't identical
+    uint32_t gpr_wr = 0;
+    uint8_t  cr_wr  = 0;
+
+    for (uint32_t i = 0; i < num_instrs; i++) {
+        if ((deps[i].gpr_rd & gpr_wr_all & ~gpr_wr) || (deps[i].cr_rd & cr_wr_all & ~cr_wr))
+            return false;
+        gpr_wr |= deps[i].gpr_wr;
+        cr_wr  |= deps[i].cr_wr;
+    }
+
+    return true;
+}
+
+static DecodedInstr* last_idle_branch;
+static uint64_t      last_idle_cycles;
+static uint64_t      idle_skip;
+
+void ppc_idle_loop_slow(DecodedInstr* head_slot, const uint8_t* head_host_va,
+                        uint32_t num_instrs, uint64_t next_event)
+{
+    DecodedInstr* branch_slot = head_slot + num_instrs - 1;
+
+    if (!(branch_slot->flags & DC_FLAG_IDLE_CHECKED)) {
+        branch_slot->flags |= DC_FLAG_IDLE_CHECKED;
+        if (idle_loop_analyze(head_slot, head_host_va, num_instrs)) {
+            branch_slot->flags |= DC_FLAG_IDLE_LOOP;
+            LOG_F(9, "Idle loop detected, %d instructions", num_instrs);
+        }
+    }
+
+    if (!(branch_slot->flags & DC_FLAG_IDLE_LOOP))
+        return;
+
+    // double the skip amount while the loop keeps spinning,
+    // start over when anything else has been executed in between
+    if (branch_slot == last_idle_branch && g_icycles - last_idle_cycles <= num_instrs) {
+        if (idle_skip < IDLE_SKIP_MAX)
+            idle_skip <<= 1;
+    } else {
+        idle_skip = num_instrs;
+    }
+    last_idle_branch = branch_slot;
+
+    if (idle_events_seen) {
+        // the iteration that just ended may predate a timer callback,
+        // run the loop once more before skipping
+        idle_events_seen = false;
+    } else if (next_event > g_icycles) {
+        uint64_t skip = std::min(idle_skip, next_event - g_icycles);
+        g_icycles += skip;
+        idle_cycles_skipped += skip;
+#ifdef CPU_PROFILING
+        num_idle_cycles_skipped += skip;
+#endif
+    }
+
+    last_idle_cycles = g_icycles;
+}
+
+bool ppc_idle_loop_head(uint32_t head_va, DecodedInstr* head_slot, const uint8_t* head_host_va)
+{
+    for (uint32_t i = 0; i < IDLE_LOOP_MAX_INSTRS; i++) {
+        if (!head_slot[i].handler)
+            decode_cache_fill(&head_slot[i], head_host_va + i * 4);
+
+        uint32_t opcode  = head_slot[i].opcode;
+        uint32_t primary = opcode >> 26;
+
+        if (primary == 16 || primary == 18) {
+            int32_t disp = (primary == 16) ? int16_t(opcode & 0xFFFC)
+                                           : int32_t((opcode & 0x03FFFFFC) << 6) >> 6;
+            if (opcode & 2) // absolute branch
+                return false;
+
+            if (disp == -int32_t(i * 4)) {
+                if (!(head_slot[i].flags & DC_FLAG_IDLE_CHECKED)) {
+                    head_slot[i].flags |= DC_FLAG_IDLE_CHECKED;
+                    if (idle_loop_analyze(head_slot, head_host_va, i + 1))
+                        head_slot[i].flags |= DC_FLAG_IDLE_LOOP;
+                }
+                return head_slot[i].flags & DC_FLAG_IDLE_LOOP;
+            }
+
+            // keep looking past conditional loop exits only
+            if (primary == 18 || disp < 0)
+                return false;
+        } else if (primary == 19) {
+            return false;
+        }
+
+        // loops don't cross page boundaries
+        if (!((head_va + i * 4 + 4) & 0xFFF))
+            return false;
+    }
+
+    return false;
+}
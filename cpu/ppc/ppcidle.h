@@ -0,0 +1,83 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Idle loop detection.
+
+    A short backward loop is considered idle when every iteration does
+    exactly the same thing unless something outside the loop changes:
+    it may only load from memory, read the time base/decrementer, compute
+    and compare, and no register may carry a value from one iteration
+    to the next. Such a loop can only exit after a timer fired, an
+    interrupt arrived or the time base moved on.
+
+    Instead of interpreting such loops, the execution loops advance
+    virtual time towards the next timer event. The amount skipped per
+    iteration doubles while the loop keeps spinning, so that polling
+    the time base for short delays doesn't overshoot by much.
+ */
+
+#ifndef PPC_IDLE_H
+#define PPC_IDLE_H
+
+#include "ppcdecodecache.h"
+
+#include <cinttypes>
+
+/** Max length of a loop considered for idle detection, in instructions. */
+constexpr uint32_t IDLE_LOOP_MAX_INSTRS = 8;
+
+/** Tells whether idle loops get fast-forwarded. */
+extern bool idle_skip_enabled;
+
+/** Total number of cycles skipped so far. */
+extern uint64_t idle_cycles_skipped;
+
+/** Set after events were processed: whatever a loop waits for may have
+    happened, so it must run once more before it can be skipped again. */
+extern bool idle_events_seen;
+
+extern void ppc_idle_loop_slow(DecodedInstr* head_slot, const uint8_t* head_host_va,
+                               uint32_t num_instrs, uint64_t next_event);
+
+/** To be called by the execution loops for each taken branch that stays
+    in the current page. branch_va/branch_slot refer to the branch,
+    target_va/target_host_va to its target. Advances g_icycles up to
+    next_event if the branch closes an idle loop. */
+inline void ppc_idle_check(uint32_t branch_va, DecodedInstr* branch_slot,
+                           uint32_t target_va, const uint8_t* target_host_va,
+                           uint64_t next_event) {
+    uint32_t dist = branch_va - target_va;
+
+    if (dist >= IDLE_LOOP_MAX_INSTRS * 4 || !idle_skip_enabled)
+        return;
+
+    // quick exit for loops already known to be busy
+    if ((branch_slot->flags & (DC_FLAG_IDLE_CHECKED | DC_FLAG_IDLE_LOOP)) == DC_FLAG_IDLE_CHECKED)
+        return;
+
+    ppc_idle_loop_slow(branch_slot - (dist >> 2), target_host_va, (dist >> 2) + 1, next_event);
+}
+
+/** Tells whether the code at head_va is the start of an idle loop. */
+extern bool ppc_idle_loop_head(uint32_t head_va, DecodedInstr* head_slot,
+                               const uint8_t* head_host_va);
+
+#endif // PPC_IDLE_H
@@ -0,0 +1,1362 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Dynamic recompiler for hot PowerPC code blocks (x86-64 hosts). */
+
+#include <devices/memctrl/fastmem.h>
+#include <loguru.hpp>
+#include "ppcdecodecache.h"
+#include "ppcemu.h"
+#include "ppcidle.h"
+#include "ppcjit.h"
+#include "ppcmmu.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+bool jit_enabled     = false;
+bool jit_block_stale = false;
+
+#if defined(__x86_64__) && !defined(_WIN32)
+
+#include <sys/mman.h>
+
+constexpr uint32_t JIT_TABLE_SIZE       = 65536;    // entries in the block table
+constexpr uint32_t JIT_HOT_THRESHOLD    = 32;       // executions before compiling a block
+constexpr uint32_t JIT_MAX_PAGE_GEN     = 8;        // don't compile pages modified that often
+constexpr uint32_t JIT_MAX_BLOCK_INSTRS = 64;       // max guest instructions per block
+constexpr size_t   JIT_MAX_BLOCK_BYTES  = 16384;    // max host code size per block
+constexpr size_t   JIT_CODE_SIZE        = 32 << 20; // size of the code buffer
+
+static_assert(sizeof(TLBEntry) == 32, "TLB lookup code assumes 32 byte entries");
+
+typedef struct JitEntry {
+    uint32_t    phys;   // physical address of the block, 1 if unused
+    uint32_t    va;     // guest virtual address of the block
+    uint32_t    count;  // number of executions so far
+    uint8_t     gen;    // page generation the entry belongs to
+    JitCode     code;   // host code, nullptr if not compiled yet
+    uint8_t*    body;   // host code past the prologue, entered by chained blocks
+} JitEntry;
+
+static_assert(sizeof(JitEntry) == 32, "inline block lookup assumes 32 byte entries");
+
+/** Successor link embedded in the code of a block, filled in on first use. */
+typedef struct JitLink {
+    uint8_t*    body;   // successor code past the prologue, nullptr if unresolved
+    uint32_t    phys;   // physical address of the successor
+    uint32_t    va;     // guest virtual address of the successor
+} JitLink;
+
+static JitEntry jit_table[JIT_TABLE_SIZE];
+
+// unresolved link the last block exited through
+static JitLink* jit_exit_link = nullptr;
+
+uint64_t jit_cycle_limit;
+
+// per physical page counter of code modifications
+static uint8_t jit_page_gen[1 << 20];
+
+static uint8_t* code_buf = nullptr;
+static uint8_t* code_ptr;
+
+/* ------------------------- x86-64 code emitter ------------------------- */
+
+enum X64Reg : int {
+    RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+enum X64Cond : uint8_t {
+    CC_C  = 0x2,
+    CC_B  = 0x2,
+    CC_AE = 0x3,
+    CC_E  = 0x4,
+    CC_NE = 0x5,
+    CC_A  = 0x7,
+    CC_L  = 0xC,
+    CC_G  = 0xF,
+};
+
+// group 1 ALU operations (81 /ext)
+enum X64Alu : uint8_t {
+    ALU_ADD = 0, ALU_OR = 1, ALU_ADC = 2, ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7
+};
+
+// group 2 shift operations (C1 /ext)
+enum X64Shift : uint8_t {
+    SH_ROL = 0, SH_SHL = 4, SH_SHR = 5
+};
+
+class X64Emitter {
+public:
+    X64Emitter(uint8_t* buf) : start(buf), p(buf) {}
+
+    uint8_t* pos()  { return p; }
+    size_t   size() { return p - start; }
+
+    void byte(uint8_t b) { *p++ = b; }
+
+    void dword(uint32_t v) {
+        std::memcpy(p, &v, 4);
+        p += 4;
+    }
+
+    void qword(uint64_t v) {
+        std::memcpy(p, &v, 8);
+        p += 8;
+    }
+
+    // REX prefix, omitted when not required
+    void rex(bool w, int reg, int base) {
+        uint8_t r = 0x40 | (w << 3) | ((reg >> 3) << 2) | (base >> 3);
+        if (r != 0x40)
+            byte(r);
+    }
+
+    // ModRM (+ SIB + displacement) for [base + disp]
+    void modrm_mem(int reg, int base, int32_t disp) {
+        int mod = (!disp && (base & 7) != RBP) ? 0 : (disp >= -128 && disp <= 127) ? 1 : 2;
+        byte((mod << 6) | ((reg & 7) << 3) | (base & 7));
+        if ((base & 7) == RSP)
+            byte(0x24);
+        if (mod == 1)
+            byte(disp);
+        else if (mod == 2)
+            dword(disp);
+    }
+
+    void modrm_reg(int reg, int rm) {
+        byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    // opcode reg, [base + disp]
+    void op_mem(uint8_t opc, int reg, int base, int32_t disp, bool w = false) {
+        rex(w, reg, base);
+        byte(opc);
+        modrm_mem(reg, base, disp);
+    }
+
+    // two byte opcode reg, [base + disp]
+    void op2_mem(uint8_t opc, int reg, int base, int32_t disp) {
+        rex(false, reg, base);
+        byte(0x0F);
+        byte(opc);
+        modrm_mem(reg, base, disp);
+    }
+
+    // opcode reg, rm (register form)
+    void op_reg(uint8_t opc, int reg, int rm, bool w = false) {
+        rex(w, reg, rm);
+        byte(opc);
+        modrm_reg(reg, rm);
+    }
+
+    void op2_reg(uint8_t opc, int reg, int rm) {
+        rex(false, reg, rm);
+        byte(0x0F);
+        byte(opc);
+        modrm_reg(reg, rm);
+    }
+
+    void load32(int reg, int base, int32_t disp)    { op_mem(0x8B, reg, base, disp); }
+    void load64(int reg, int base, int32_t disp)    { op_mem(0x8B, reg, base, disp, true); }
+    void store32(int base, int32_t disp, int reg)   { op_mem(0x89, reg, base, disp); }
+    void movzx8(int reg, int base, int32_t disp)    { op2_mem(0xB6, reg, base, disp); }
+    void movzx16(int reg, int base, int32_t disp)   { op2_mem(0xB7, reg, base, disp); }
+    void movzx8_reg(int dst, int src)               { op2_reg(0xB6, dst, src); }
+    void movzx16_reg(int dst, int src)              { op2_reg(0xB7, dst, src); }
+    void movsx8_reg(int dst, int src)               { op2_reg(0xBE, dst, src); }
+    void movsx16_reg(int dst, int src)              { op2_reg(0xBF, dst, src); }
+    void mov_reg(int dst, int src)                  { op_reg(0x89, src, dst); }
+    void test_reg(int dst, int src)                 { op_reg(0x85, src, dst); }
+    void imul_reg(int dst, int src)                 { op2_reg(0xAF, dst, src); }
+    void cmov(X64Cond cc, int dst, int src)         { op2_reg(0x40 | cc, dst, src); }
+    void setcc(X64Cond cc, int reg)                 { op2_reg(0x90 | cc, 0, reg); }
+
+    // bt reg, imm8
+    void bt_imm(int reg, uint8_t bit) {
+        op2_reg(0xBA, 4, reg);
+        byte(bit);
+    }
+
+    // ALU op reg, [base + disp]
+    void alu_mem(X64Alu alu, int reg, int base, int32_t disp, bool w = false) {
+        op_mem((alu << 3) | 3, reg, base, disp, w);
+    }
+
+    // ALU op dst, src
+    void alu_reg(X64Alu alu, int dst, int src, bool w = false) {
+        op_reg((alu << 3) | 1, src, dst, w);
+    }
+
+    // ALU op reg, imm32
+    void alu_imm(X64Alu alu, int reg, uint32_t imm, bool w = false) {
+        op_reg(0x81, alu, reg, w);
+        dword(imm);
+    }
+
+    // ALU op dword/qword [base + disp], imm32
+    void alu_mem_imm(X64Alu alu, int base, int32_t disp, uint32_t imm, bool w = false) {
+        op_mem(0x81, alu, base, disp, w);
+        dword(imm);
+    }
+
+    void shift_imm(X64Shift sh, int reg, uint8_t count) {
+        op_reg(0xC1, sh, reg);
+        byte(count);
+    }
+
+    void mov_imm(int reg, uint32_t imm) {
+        rex(false, 0, reg);
+        byte(0xB8 | (reg & 7));
+        dword(imm);
+    }
+
+    void mov_imm64(int reg, uint64_t imm) {
+        rex(true, 0, reg);
+        byte(0xB8 | (reg & 7));
+        qword(imm);
+    }
+
+    void store32_imm(int base, int32_t disp, uint32_t imm) {
+        op_mem(0xC7, 0, base, disp);
+        dword(imm);
+    }
+
+    void imul_mem_imm(int dst, int base, int32_t disp, int32_t imm) {
+        op_mem(0x69, dst, base, disp);
+        dword(imm);
+    }
+
+    void not_reg(int reg)   { op_reg(0xF7, 2, reg); }
+    void neg_reg(int reg)   { op_reg(0xF7, 3, reg); }
+    void bswap(int reg)     { rex(false, 0, reg); byte(0x0F); byte(0xC8 | (reg & 7)); }
+
+    // rol ax, 8 - swap bytes of the low word
+    void bswap16(int reg) {
+        byte(0x66);
+        op_reg(0xC1, SH_ROL, reg);
+        byte(8);
+    }
+
+    void test_al(uint8_t imm)   { byte(0xA8); byte(imm); }
+    void jmp_reg(int reg)       { rex(false, 0, reg); byte(0xFF); modrm_reg(4, reg); }
+
+    // cmp byte [base + disp], 0
+    void cmp_byte_zero(int base, int32_t disp) {
+        op_mem(0x80, ALU_CMP, base, disp);
+        byte(0);
+    }
+
+    // RIP-relative mov reg, [target] and lea reg, [target] to be resolved by bind()
+    uint8_t* load64_rip(int reg) { return rip_op(0x8B, reg); }
+    uint8_t* lea_rip(int reg)    { return rip_op(0x8D, reg); }
+
+    void align(size_t n) {
+        while ((uintptr_t)p & (n - 1))
+            byte(0xCC);
+    }
+    void push(int reg)          { rex(false, 0, reg); byte(0x50 | (reg & 7)); }
+    void pop(int reg)           { rex(false, 0, reg); byte(0x58 | (reg & 7)); }
+    void ret()                  { byte(0xC3); }
+
+    void call(const void* fn) {
+        mov_imm64(RAX, (uint64_t)fn);
+        byte(0xFF);
+        byte(0xD0); // call rax
+    }
+
+    // jumps with a 32-bit displacement to be resolved by bind()
+    uint8_t* jcc(X64Cond cc) {
+        byte(0x0F);
+        byte(0x80 | cc);
+        dword(0);
+        return p;
+    }
+
+    uint8_t* jmp() {
+        byte(0xE9);
+        dword(0);
+        return p;
+    }
+
+    void bind(uint8_t* jump_end) { bind(jump_end, p); }
+
+    void bind(uint8_t* jump_end, uint8_t* target) {
+        int32_t rel = (int32_t)(target - jump_end);
+        std::memcpy(jump_end - 4, &rel, 4);
+    }
+
+private:
+    uint8_t* rip_op(uint8_t opc, int reg) {
+        rex(true, reg, 0);
+        byte(opc);
+        byte(((reg & 7) << 3) | 5);
+        dword(0);
+        return p;
+    }
+
+    uint8_t* start;
+    uint8_t* p;
+};
+
+/* ------------------------------ compiler ------------------------------- */
+
+// Register assignment inside translated blocks (callee-saved registers only).
+constexpr int REG_STATE  = RBX; // &ppc_state
+constexpr int REG_STALE  = RBP; // &jit_block_stale
+constexpr int REG_CYCLES = R12; // &g_icycles
+constexpr int REG_FLAGS  = R13; // &exec_flags
+constexpr int REG_INSTR  = R14; // &ppc_cur_instruction
+constexpr int REG_DTLB   = R15; // &pCurDTLB1
+
+static inline int32_t gpr_offs(int reg) {
+    return (int32_t)(offsetof(SetPRS, gpr) + reg * sizeof(uint32_t));
+}
+
+static inline int32_t spr_offs(int spr) {
+    return (int32_t)(offsetof(SetPRS, spr) + spr * sizeof(uint32_t));
+}
+
+constexpr int32_t PC_OFFS = (int32_t)offsetof(SetPRS, pc);
+constexpr int32_t CR_OFFS = (int32_t)offsetof(SetPRS, cr);
+
+static inline uint32_t rot_mask(unsigned rot_mb, unsigned rot_me) {
+    uint32_t m1 = 0xFFFFFFFFUL >> rot_mb;
+    uint32_t m2 = uint32_t(0xFFFFFFFFUL << (31 - rot_me));
+    return ((rot_mb <= rot_me) ? m2 & m1 : m1 | m2);
+}
+
+// access size of the integer load/store opcodes 32...45
+static inline int ls_size(uint32_t opcode) {
+    switch (opcode >> 26) {
+    case 32: case 33: case 36: case 37: // lwz[u], stw[u]
+        return 4;
+    case 40: case 41: case 44: case 45: // lhz[u], sth[u]
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+class JitCompiler {
+public:
+    JitCompiler(uint8_t* buf) : a(buf) {}
+
+    JitCode compile(uint32_t va, uint32_t phys, DecodedInstr* slot, const uint8_t* host_va);
+
+    uint8_t* code_end()   { return a.pos(); }
+    uint8_t* code_body()  { return body; }
+
+private:
+    bool compile_instr(uint32_t va, DecodedInstr* slot);
+
+    void emit_prologue();
+    void emit_epilogue();
+    void emit_interp_call(uint32_t va, uint32_t opcode, PPCOpcode handler);
+    void emit_exit_check(uint32_t cycles);
+    void emit_cr_update(int crf_d, X64Cond lt, X64Cond gt);
+    void emit_cr0_update();
+    void emit_get_ca();
+    void emit_set_ca(X64Cond cc);
+    void emit_load(uint32_t va, uint32_t opcode, int size, bool update);
+    void emit_store(uint32_t va, uint32_t opcode, int size, bool update);
+    void emit_ea_update(uint32_t opcode);
+    void emit_ea(uint32_t opcode);
+    uint8_t* emit_dtlb_lookup(int size, bool is_store, std::vector<uint8_t*>& slow);
+    void emit_fastmem_lookup(int size, bool is_store, std::vector<uint8_t*>& slow,
+                             uint8_t* access);
+    void emit_b(uint32_t va, uint32_t opcode);
+    void emit_bc(uint32_t va, uint32_t opcode);
+    void emit_bclr(uint32_t va, uint32_t opcode);
+    void emit_bc_cond(uint32_t opcode, std::vector<uint8_t*>& not_taken);
+    void emit_chain_checks(std::vector<uint8_t*>& exit);
+    void emit_chain_exit(uint32_t target, uint32_t last_va, uint32_t cycles);
+    void emit_dyn_chain_exit(uint32_t last_va, uint32_t cycles);
+    bool emit_opcode31(uint32_t opcode);
+
+    void load_gpr(int reg, int gpr)   { a.load32(reg, REG_STATE, gpr_offs(gpr)); }
+    void store_gpr(int gpr, int reg)  { a.store32(REG_STATE, gpr_offs(gpr), reg); }
+
+    void add_cycles(uint32_t n) {
+        if (n)
+            a.alu_mem_imm(ALU_ADD, REG_CYCLES, 0, n, true);
+    }
+
+    X64Emitter              a;
+    uint32_t                pending = 0; // executed instructions not yet added to g_icycles
+    std::vector<uint8_t*>   exits;       // jumps to the epilogue
+    uint32_t                block_va;    // guest virtual address of the block
+    uint32_t                block_phys;  // physical address of the block
+    uint8_t*                body;        // code past the prologue
+    bool                    closed;      // block end has been emitted already
+};
+
+void JitCompiler::emit_prologue() {
+    a.push(RBX);
+    a.push(RBP);
+    a.push(R12);
+    a.push(R13);
+    a.push(R14);
+    a.push(R15);
+    a.alu_imm(ALU_SUB, RSP, 8, true); // keep the stack 16-byte aligned for calls
+    a.mov_imm64(REG_STATE,  (uint64_t)&ppc_state);
+    a.mov_imm64(REG_STALE,  (uint64_t)&jit_block_stale);
+    a.mov_imm64(REG_CYCLES, (uint64_t)&g_icycles);
+    a.mov_imm64(REG_FLAGS,  (uint64_t)&exec_flags);
+    a.mov_imm64(REG_INSTR,  (uint64_t)&ppc_cur_instruction);
+    a.mov_imm64(REG_DTLB,   (uint64_t)&pCurDTLB1);
+}
+
+void JitCompiler::emit_epilogue() {
+    for (auto j : exits)
+        a.bind(j);
+    a.alu_imm(ALU_ADD, RSP, 8, true);
+    a.pop(R15);
+    a.pop(R14);
+    a.pop(R13);
+    a.pop(R12);
+    a.pop(RBP);
+    a.pop(RBX);
+    a.ret();
+}
+
+// Leave the block if the last call requested a control transfer,
+// modified the code of this block or powered the CPU off.
+void JitCompiler::emit_exit_check(uint32_t cycles) {
+    a.movzx8(RAX, REG_STALE, 0);
+    a.alu_mem(ALU_OR, RAX, REG_FLAGS, 0);
+    uint8_t* j_exit = a.jcc(CC_NE);
+    a.mov_imm64(RAX, (uint64_t)&power_on);
+    a.op_mem(0x80, ALU_CMP, RAX, 0); // cmp byte [rax], 0
+    a.byte(0);
+    uint8_t* j_cont = a.jcc(CC_NE);
+    a.bind(j_exit);
+    add_cycles(cycles);
+    exits.push_back(a.jmp());
+    a.bind(j_cont);
+}
+
+void JitCompiler::emit_interp_call(uint32_t va, uint32_t opcode, PPCOpcode handler) {
+    a.store32_imm(REG_STATE, PC_OFFS, va);
+    a.store32_imm(REG_INSTR, 0, opcode);
+    add_cycles(pending);
+    a.call((const void*)handler);
+    // compiled code accesses the CR directly so compute a CR0
+    // left pending by a record-form instruction right away
+    a.mov_imm64(RAX, (uint64_t)&cr0_pending);
+    a.cmp_byte_zero(RAX, 0);
+    uint8_t* j_synced = a.jcc(CC_E);
+    a.call((const void*)&ppc_cr0_materialize);
+    a.bind(j_synced);
+    emit_exit_check(1);
+    pending = 1;
+}
+
+// Build a CR field from host flags set by a preceding cmp/test.
+void JitCompiler::emit_cr_update(int crf_d, X64Cond lt, X64Cond gt) {
+    a.mov_imm(RCX, 0x20000000UL);
+    a.mov_imm(RDX, 0x80000000UL);
+    a.cmov(lt, RCX, RDX);
+    a.mov_imm(RDX, 0x40000000UL);
+    a.cmov(gt, RCX, RDX);
+    a.load32(RDX, REG_STATE, spr_offs(SPR::XER));
+    a.shift_imm(SH_SHR, RDX, 3);
+    a.alu_imm(ALU_AND, RDX, XER::SO >> 3);
+    a.alu_reg(ALU_OR, RCX, RDX);
+    if (crf_d)
+        a.shift_imm(SH_SHR, RCX, crf_d);
+    a.load32(RDX, REG_STATE, CR_OFFS);
+    a.alu_imm(ALU_AND, RDX, ~(0xF0000000UL >> crf_d));
+    a.alu_reg(ALU_OR, RDX, RCX);
+    a.store32(REG_STATE, CR_OFFS, RDX);
+}
+
+// Update CR0 from the result in EAX.
+void JitCompiler::emit_cr0_update() {
+    a.test_reg(RAX, RAX);
+    emit_cr_update(0, CC_L, CC_G);
+}
+
+// Move XER[CA] into the host carry flag.
+void JitCompiler::emit_get_ca() {
+    a.load32(RCX, REG_STATE, spr_offs(SPR::XER));
+    a.bt_imm(RCX, 29);
+}
+
+// Set XER[CA] from a host condition, EAX is preserved.
+void JitCompiler::emit_set_ca(X64Cond cc) {
+    a.setcc(cc, RCX);
+    a.movzx8_reg(RCX, RCX);
+    a.shift_imm(SH_SHL, RCX, 29);
+    a.load32(RDX, REG_STATE, spr_offs(SPR::XER));
+    a.alu_imm(ALU_AND, RDX, ~XER::CA);
+    a.alu_reg(ALU_OR, RDX, RCX);
+    a.store32(REG_STATE, spr_offs(SPR::XER), RDX);
+}
+
+// Compute the D-form effective address (rA|0) + SIMM into EAX.
+void JitCompiler::emit_ea(uint32_t opcode) {
+    int reg_a    = (opcode >> 16) & 31;
+    int32_t simm = int32_t(int16_t(opcode));
+
+    if (reg_a) {
+        load_gpr(RAX, reg_a);
+        if (simm)
+            a.alu_imm(ALU_ADD, RAX, simm);
+    } else {
+        a.mov_imm(RAX, simm);
+    }
+}
+
+// Write the effective address back to rA for the update forms.
+void JitCompiler::emit_ea_update(uint32_t opcode) {
+    emit_ea(opcode);
+    store_gpr((opcode >> 16) & 31, RAX);
+}
+
+// Look up the effective address in EAX in the primary DTLB.
+// Leaves the host address in RCX or jumps to one of the slow labels.
+// Returns the jump taken on a primary DTLB miss.
+uint8_t* JitCompiler::emit_dtlb_lookup(int size, bool is_store, std::vector<uint8_t*>& slow) {
+    a.load64(RDX, REG_DTLB, 0);
+    a.mov_reg(RCX, RAX);
+    a.shift_imm(SH_SHR, RCX, PPC_PAGE_SIZE_BITS);
+    a.alu_imm(ALU_AND, RCX, TLB_SIZE - 1);
+    a.shift_imm(SH_SHL, RCX, 5);
+    a.alu_reg(ALU_ADD, RDX, RCX, true);
+    a.mov_reg(RCX, RAX);
+    a.alu_imm(ALU_AND, RCX, PPC_PAGE_MASK);
+    a.mov_reg(R8, RAX);
+    a.shift_imm(SH_SHR, R8, 28);
+    a.shift_imm(SH_SHL, R8, 2);
+    a.mov_imm64(R9, (uint64_t)CurDTLBSegCtx);
+    a.alu_reg(ALU_ADD, R8, R9, true);
+    a.alu_mem(ALU_OR, RCX, R8, 0); // add the context of the segment
+    a.alu_mem(ALU_CMP, RCX, RDX, offsetof(TLBEntry, tag));
+    uint8_t* j_miss = a.jcc(CC_NE);
+
+    // unaligned accesses are left to the MMU code
+    if (size > 1) {
+        a.test_al(size - 1);
+        slow.push_back(a.jcc(CC_NE));
+    }
+
+    if (is_store) {
+        // page must be writable with the PTE.C bit already set,
+        // writes to video memory are tracked by the MMU code
+        a.movzx16(RCX, RDX, offsetof(TLBEntry, flags));
+        a.alu_imm(ALU_AND, RCX, TLBFlags::PAGE_WRITABLE | TLBFlags::PTE_SET_C |
+                                TLBFlags::PAGE_VRAM);
+        a.alu_imm(ALU_CMP, RCX, TLBFlags::PAGE_WRITABLE | TLBFlags::PTE_SET_C);
+        slow.push_back(a.jcc(CC_NE));
+
+        // writes to pages holding code need to go through the MMU code
+        a.load32(RCX, RDX, offsetof(TLBEntry, phys_tag));
+        a.shift_imm(SH_SHR, RCX, PPC_PAGE_SIZE_BITS);
+        a.mov_imm64(R8, (uint64_t)dc_code_page_bits);
+        a.op2_mem(0xA3, RCX, R8, 0); // bt [r8], ecx
+        slow.push_back(a.jcc(CC_C));
+    }
+
+    a.mov_reg(RCX, RAX);
+    a.alu_mem(ALU_ADD, RCX, RDX,
+        is_store ? offsetof(TLBEntry, host_va_offs_w) : offsetof(TLBEntry, host_va_offs_r), true);
+
+    return j_miss;
+}
+
+// Untranslated accesses to memory don't use the DTLB if guest physical
+// memory is host-mapped. Leaves the window address of EAX in RCX and
+// continues at access or jumps to one of the slow labels.
+void JitCompiler::emit_fastmem_lookup(int size, bool is_store, std::vector<uint8_t*>& slow,
+                                      uint8_t* access) {
+    a.mov_imm64(R8, (uint64_t)&pFastDMem);
+    a.load64(R8, R8, 0);
+    a.alu_imm(ALU_CMP, R8, 0, true);
+    slow.push_back(a.jcc(CC_E));
+
+    // the fault handler relies on naturally aligned accesses
+    if (size > 1) {
+        a.test_al(size - 1);
+        slow.push_back(a.jcc(CC_NE));
+    }
+
+    // MMIO is left to the MMU code so that it gets cached in the DTLB
+    a.mov_reg(RCX, RAX);
+    a.shift_imm(SH_SHR, RCX, FASTMEM_PAGE_BITS);
+    a.mov_imm64(R9, (uint64_t)fastmem_page_bits);
+    a.op2_mem(0xA3, RCX, R9, 0); // bt [r9], ecx
+    slow.push_back(a.jcc(CC_AE)); // CF clear
+
+    if (is_store) {
+        // writes to pages holding code need to go through the MMU code
+        a.mov_imm64(R9, (uint64_t)dc_code_page_bits);
+        a.op2_mem(0xA3, RCX, R9, 0); // bt [r9], ecx
+        slow.push_back(a.jcc(CC_C));
+    }
+
+    a.mov_reg(RCX, RAX);
+    a.alu_reg(ALU_ADD, RCX, R8, true);
+    a.bind(a.jmp(), access);
+}
+
+void JitCompiler::emit_load(uint32_t va, uint32_t opcode, int size, bool update) {
+    std::vector<uint8_t*> slow;
+    int reg_d = (opcode >> 21) & 31;
+
+    emit_ea(opcode);
+    uint8_t* j_miss = emit_dtlb_lookup(size, false, slow);
+    uint8_t* access = a.pos();
+
+    switch (size) {
+    case 1:
+        a.movzx8(RAX, RCX, 0);
+        break;
+    case 2:
+        a.movzx16(RAX, RCX, 0);
+        a.bswap16(RAX);
+        break;
+    default:
+        a.load32(RAX, RCX, 0);
+        a.bswap(RAX);
+    }
+    store_gpr(reg_d, RAX);
+    uint8_t* j_done = a.jmp();
+
+    a.bind(j_miss);
+    emit_fastmem_lookup(size, false, slow, access);
+    for (auto j : slow)
+        a.bind(j);
+    a.store32_imm(REG_STATE, PC_OFFS, va);
+    a.store32_imm(REG_INSTR, 0, opcode);
+    add_cycles(pending);
+    a.mov_reg(RDI, RAX);
+    switch (size) {
+    case 1:
+        a.call((const void*)&mmu_read_vmem<uint8_t>);
+        a.movzx8_reg(RAX, RAX);
+        break;
+    case 2:
+        a.call((const void*)&mmu_read_vmem<uint16_t>);
+        a.movzx16_reg(RAX, RAX);
+        break;
+    default:
+        a.call((const void*)&mmu_read_vmem<uint32_t>);
+    }
+    a.mov_reg(RDX, RAX);
+    emit_exit_check(1); // rD stays untouched if the access faulted
+    store_gpr(reg_d, RDX);
+    if (pending)
+        a.alu_mem_imm(ALU_SUB, REG_CYCLES, 0, pending, true);
+
+    a.bind(j_done);
+    if (update)
+        emit_ea_update(opcode);
+    pending++;
+}
+
+void JitCompiler::emit_store(uint32_t va, uint32_t opcode, int size, bool update) {
+    std::vector<uint8_t*> slow;
+    int reg_s = (opcode >> 21) & 31;
+
+    emit_ea(opcode);
+    uint8_t* j_miss = emit_dtlb_lookup(size, true, slow);
+    uint8_t* access = a.pos();
+
+    load_gpr(RAX, reg_s);
+    switch (size) {
+    case 1:
+        a.op_mem(0x88, RAX, RCX, 0); // mov [rcx], al
+        break;
+    case 2:
+        a.bswap16(RAX);
+        a.byte(0x66);
+        a.store32(RCX, 0, RAX);      // mov [rcx], ax
+        break;
+    default:
+        a.bswap(RAX);
+        a.store32(RCX, 0, RAX);
+    }
+    uint8_t* j_done = a.jmp();
+
+    a.bind(j_miss);
+    emit_fastmem_lookup(size, true, slow, access);
+    for (auto j : slow)
+        a.bind(j);
+    a.store32_imm(REG_STATE, PC_OFFS, va);
+    a.store32_imm(REG_INSTR, 0, opcode);
+    add_cycles(pending);
+    a.mov_reg(RDI, RAX);
+    load_gpr(RSI, reg_s);
+    switch (size) {
+    case 1:
+        a.call((const void*)&mmu_write_vmem<uint8_t>);
+        break;
+    case 2:
+        a.call((const void*)&mmu_write_vmem<uint16_t>);
+        break;
+    default:
+        a.call((const void*)&mmu_write_vmem<uint32_t>);
+    }
+    emit_exit_check(1);
+    if (pending)
+        a.alu_mem_imm(ALU_SUB, REG_CYCLES, 0, pending, true);
+
+    a.bind(j_done);
+    if (update)
+        emit_ea_update(opcode);
+    pending++;
+}
+
+// Checks done before entering a successor block directly: leave to the
+// dispatcher if code got modified, the time slice is over or timers changed.
+void JitCompiler::emit_chain_checks(std::vector<uint8_t*>& exit) {
+    a.cmp_byte_zero(REG_STALE, 0);
+    exit.push_back(a.jcc(CC_NE));
+    a.mov_imm64(RCX, (uint64_t)&jit_cycle_limit);
+    a.load64(RAX, REG_CYCLES, 0);
+    a.alu_mem(ALU_CMP, RAX, RCX, 0, true);
+    exit.push_back(a.jcc(CC_AE));
+    // a plain byte load is an acquire load on x86-64
+    static_assert(sizeof(events_pending) == 1, "events_pending must be a single byte");
+    a.mov_imm64(RCX, (uint64_t)&events_pending);
+    a.cmp_byte_zero(RCX, 0);
+    exit.push_back(a.jcc(CC_NE));
+}
+
+// Leave the block towards a fixed target. Targets within the same page are
+// linked directly to their block once the dispatcher has seen it compiled.
+void JitCompiler::emit_chain_exit(uint32_t target, uint32_t last_va, uint32_t cycles) {
+    std::vector<uint8_t*> exit;
+
+    add_cycles(cycles);
+
+    if ((target & PPC_PAGE_MASK) != (block_va & PPC_PAGE_MASK)) {
+        a.store32_imm(REG_STATE, PC_OFFS, last_va);
+        exits.push_back(a.jmp());
+        return;
+    }
+
+    emit_chain_checks(exit);
+    uint8_t* link_load = a.load64_rip(RAX);
+    a.op_reg(0x85, RAX, RAX, true); // test rax, rax
+    uint8_t* j_unlinked = a.jcc(CC_E);
+    a.store32_imm(REG_FLAGS, 0, 0);
+    a.store32_imm(REG_STATE, PC_OFFS, target);
+    a.jmp_reg(RAX);
+
+    // ask the dispatcher to resolve the link
+    a.bind(j_unlinked);
+    uint8_t* link_lea = a.lea_rip(RCX);
+    a.mov_imm64(RDX, (uint64_t)&jit_exit_link);
+    a.op_mem(0x89, RCX, RDX, 0, true); // mov [rdx], rcx
+
+    for (auto j : exit)
+        a.bind(j);
+    a.store32_imm(REG_STATE, PC_OFFS, last_va);
+    exits.push_back(a.jmp());
+
+    a.align(8);
+    JitLink* link = (JitLink*)a.pos();
+    a.qword(0);
+    a.dword((block_phys & PPC_PAGE_MASK) | (target & ~PPC_PAGE_MASK));
+    a.dword(target);
+    a.bind(link_load, (uint8_t*)link);
+    a.bind(link_lea,  (uint8_t*)link);
+}
+
+// Leave the block towards the target in ppc_next_instruction_address.
+// Targets within the same page are looked up in the block table inline.
+void JitCompiler::emit_dyn_chain_exit(uint32_t last_va, uint32_t cycles) {
+    std::vector<uint8_t*> exit;
+    uint32_t page_va   = block_va & PPC_PAGE_MASK;
+    uint32_t page_phys = block_phys & PPC_PAGE_MASK;
+
+    add_cycles(cycles);
+    emit_chain_checks(exit);
+
+    a.mov_imm64(RAX, (uint64_t)&ppc_next_instruction_address);
+    a.load32(RAX, RAX, 0);
+    a.mov_reg(RCX, RAX);
+    a.alu_imm(ALU_AND, RCX, PPC_PAGE_MASK);
+    a.alu_imm(ALU_CMP, RCX, page_va);
+    exit.push_back(a.jcc(CC_NE));
+
+    // locate the table entry for the physical target address
+    a.mov_reg(RCX, RAX);
+    a.alu_imm(ALU_AND, RCX, ~PPC_PAGE_MASK);
+    a.alu_imm(ALU_OR, RCX, page_phys);
+    a.mov_reg(RDX, RCX);
+    a.shift_imm(SH_SHR, RDX, 2);
+    a.alu_imm(ALU_AND, RDX, JIT_TABLE_SIZE - 1);
+    a.shift_imm(SH_SHL, RDX, 5);
+    a.mov_imm64(R8, (uint64_t)jit_table);
+    a.alu_reg(ALU_ADD, RDX, R8, true);
+    a.alu_mem(ALU_CMP, RCX, RDX, offsetof(JitEntry, phys));
+    exit.push_back(a.jcc(CC_NE));
+    a.alu_mem(ALU_CMP, RAX, RDX, offsetof(JitEntry, va));
+    exit.push_back(a.jcc(CC_NE));
+    a.movzx8(RCX, RDX, offsetof(JitEntry, gen));
+    a.mov_imm64(R8, (uint64_t)&jit_page_gen[block_phys >> 12]);
+    a.movzx8(R9, R8, 0);
+    a.alu_reg(ALU_CMP, RCX, R9);
+    exit.push_back(a.jcc(CC_NE));
+    a.load64(RCX, RDX, offsetof(JitEntry, body));
+    a.op_reg(0x85, RCX, RCX, true); // test rcx, rcx
+    exit.push_back(a.jcc(CC_E));
+
+    a.store32_imm(REG_FLAGS, 0, 0);
+    a.store32(REG_STATE, PC_OFFS, RAX);
+    a.jmp_reg(RCX);
+
+    for (auto j : exit)
+        a.bind(j);
+    a.store32_imm(REG_STATE, PC_OFFS, last_va);
+    exits.push_back(a.jmp());
+}
+
+void JitCompiler::emit_b(uint32_t va, uint32_t opcode) {
+    int32_t adr_li = int32_t((opcode & ~3U) << 6) >> 6;
+    uint32_t target = (opcode & 2) ? adr_li : uint32_t(va + adr_li);
+
+    a.mov_imm64(RAX, (uint64_t)&ppc_next_instruction_address);
+    a.store32_imm(RAX, 0, target);
+    if (opcode & 1)
+        a.store32_imm(REG_STATE, spr_offs(SPR::LR), va + 4);
+    a.store32_imm(REG_FLAGS, 0, EXEF_BRANCH);
+
+    emit_chain_exit(target, va, pending + 1);
+}
+
+// Evaluate BO/BI of a conditional branch, decrementing CTR if requested.
+void JitCompiler::emit_bc_cond(uint32_t opcode, std::vector<uint8_t*>& not_taken) {
+    uint32_t br_bo = (opcode >> 21) & 0x1F;
+    uint32_t br_bi = (opcode >> 16) & 0x1F;
+
+    if (!(br_bo & 0x04)) {
+        a.alu_mem_imm(ALU_SUB, REG_STATE, spr_offs(SPR::CTR), 1);
+        // ZF reflects CTR == 0 now
+        not_taken.push_back(a.jcc((br_bo & 0x02) ? CC_NE : CC_E));
+    }
+
+    if (!(br_bo & 0x10)) {
+        a.op_mem(0xF7, 0, REG_STATE, CR_OFFS); // test dword [cr], imm32
+        a.dword(0x80000000UL >> br_bi);
+        not_taken.push_back(a.jcc((br_bo & 0x08) ? CC_E : CC_NE));
+    }
+}
+
+void JitCompiler::emit_bc(uint32_t va, uint32_t opcode) {
+    std::vector<uint8_t*> not_taken;
+    int32_t  br_bd  = int32_t(int16_t(opcode & ~3U));
+    uint32_t target = (opcode & 2) ? br_bd : uint32_t(va + br_bd);
+
+    emit_bc_cond(opcode, not_taken);
+
+    a.mov_imm64(RAX, (uint64_t)&ppc_next_instruction_address);
+    a.store32_imm(RAX, 0, target);
+    a.store32_imm(REG_FLAGS, 0, EXEF_BRANCH);
+    if (opcode & 1)
+        a.store32_imm(REG_STATE, spr_offs(SPR::LR), va + 4);
+    emit_chain_exit(target, va, pending + 1);
+
+    for (auto j : not_taken)
+        a.bind(j);
+    if (opcode & 1)
+        a.store32_imm(REG_STATE, spr_offs(SPR::LR), va + 4);
+    emit_chain_exit(va + 4, va, pending + 1);
+}
+
+void JitCompiler::emit_bclr(uint32_t va, uint32_t opcode) {
+    std::vector<uint8_t*> not_taken;
+
+    emit_bc_cond(opcode, not_taken);
+
+    a.load32(RAX, REG_STATE, spr_offs(SPR::LR));
+    a.alu_imm(ALU_AND, RAX, ~3U);
+    a.mov_imm64(RCX, (uint64_t)&ppc_next_instruction_address);
+    a.store32(RCX, 0, RAX);
+    a.store32_imm(REG_FLAGS, 0, EXEF_BRANCH);
+    if (opcode & 1)
+        a.store32_imm(REG_STATE, spr_offs(SPR::LR), va + 4);
+    emit_dyn_chain_exit(va, pending + 1);
+
+    for (auto j : not_taken)
+        a.bind(j);
+    if (opcode & 1)
+        a.store32_imm(REG_STATE, spr_offs(SPR::LR), va + 4);
+    emit_chain_exit(va + 4, va, pending + 1);
+}
+
+// Emit native code for simple opcode 31 forms. Returns false if the
+// instruction needs to be handled by the interpreter.
+bool JitCompiler::emit_opcode31(uint32_t opcode) {
+    int reg_d   = (opcode >> 21) & 31;
+    int reg_a   = (opcode >> 16) & 31;
+    int reg_b   = (opcode >> 11) & 31;
+    bool rc     = opcode & 1;
+    uint32_t xo = (opcode >> 1) & 0x3FF;
+
+    switch (xo) {
+    case 10:  // addc
+    case 138: // adde
+        if (xo == 138)
+            emit_get_ca();
+        load_gpr(RAX, reg_a);
+        a.alu_mem(xo == 138 ? ALU_ADC : ALU_ADD, RAX, REG_STATE, gpr_offs(reg_b));
+        emit_set_ca(CC_C);
+        store_gpr(reg_d, RAX);
+        break;
+    case 202: // addze
+        load_gpr(RAX, reg_a);
+        emit_get_ca();
+        a.alu_imm(ALU_ADC, RAX, 0);
+        emit_set_ca(CC_C);
+        store_gpr(reg_d, RAX);
+        break;
+    case 8: // subfc
+        load_gpr(RAX, reg_b);
+        a.alu_mem(ALU_SUB, RAX, REG_STATE, gpr_offs(reg_a));
+        emit_set_ca(CC_AE);
+        store_gpr(reg_d, RAX);
+        break;
+    case 136: // subfe
+        load_gpr(RAX, reg_a);
+        a.not_reg(RAX);
+        emit_get_ca();
+        a.alu_mem(ALU_ADC, RAX, REG_STATE, gpr_offs(reg_b));
+        emit_set_ca(CC_C);
+        store_gpr(reg_d, RAX);
+        break;
+    case 266: // add
+        load_gpr(RAX, reg_a);
+        a.alu_mem(ALU_ADD, RAX, REG_STATE, gpr_offs(reg_b));
+        store_gpr(reg_d, RAX);
+        break;
+    case 40: // subf
+        load_gpr(RAX, reg_b);
+        a.alu_mem(ALU_SUB, RAX, REG_STATE, gpr_offs(reg_a));
+        store_gpr(reg_d, RAX);
+        break;
+    case 104: // neg
+        load_gpr(RAX, reg_a);
+        a.neg_reg(RAX);
+        store_gpr(reg_d, RAX);
+        break;
+    case 235: // mullw
+        load_gpr(RAX, reg_a);
+        load_gpr(RCX, reg_b);
+        a.imul_reg(RAX, RCX);
+        store_gpr(reg_d, RAX);
+        break;
+    case 28:  // and
+    case 60:  // andc
+    case 124: // nor
+    case 284: // eqv
+    case 316: // xor
+    case 412: // orc
+    case 444: // or
+    case 476: // nand
+        load_gpr(RAX, reg_d);
+        load_gpr(RCX, reg_b);
+        if (xo == 60 || xo == 412)
+            a.not_reg(RCX);
+        switch (xo) {
+        case 28: case 60: case 476:
+            a.alu_reg(ALU_AND, RAX, RCX);
+            break;
+        case 284: case 316:
+            a.alu_reg(ALU_XOR, RAX, RCX);
+            break;
+        default:
+            a.alu_reg(ALU_OR, RAX, RCX);
+        }
+        if (xo == 124 || xo == 284 || xo == 476)
+            a.not_reg(RAX);
+        store_gpr(reg_a, RAX);
+        break;
+    case 954: // extsb
+        load_gpr(RAX, reg_d);
+        a.movsx8_reg(RAX, RAX);
+        store_gpr(reg_a, RAX);
+        break;
+    case 922: // extsh
+        load_gpr(RAX, reg_d);
+        a.movsx16_reg(RAX, RAX);
+        store_gpr(reg_a, RAX);
+        break;
+    case 0:  // cmp
+    case 32: // cmpl
+        if (opcode & 0x200000)
+            return false;
+        load_gpr(RAX, reg_a);
+        a.alu_mem(ALU_CMP, RAX, REG_STATE, gpr_offs(reg_b));
+        if (xo)
+            emit_cr_update(reg_d & 0x1C, CC_B, CC_A);
+        else
+            emit_cr_update(reg_d & 0x1C, CC_L, CC_G);
+        return true;
+    case 19: // mfcr
+        a.load32(RAX, REG_STATE, CR_OFFS);
+        store_gpr(reg_d, RAX);
+        return true;
+    case 339: // mfspr
+    case 467: // mtspr
+    {
+        uint32_t ref_spr = (reg_b << 5) | reg_a;
+        if (ref_spr != SPR::LR && ref_spr != SPR::CTR)
+            return false;
+        if (xo == 339) {
+            a.load32(RAX, REG_STATE, spr_offs(ref_spr));
+            store_gpr(reg_d, RAX);
+        } else {
+            load_gpr(RAX, reg_d);
+            a.store32(REG_STATE, spr_offs(ref_spr), RAX);
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+
+    if (rc)
+        emit_cr0_update();
+
+    return true;
+}
+
+// Compile one instruction. Returns true if it terminates the block.
+bool JitCompiler::compile_instr(uint32_t va, DecodedInstr* slot) {
+    uint32_t opcode = slot->opcode;
+    int reg_d       = (opcode >> 21) & 31;
+    int reg_a       = (opcode >> 16) & 31;
+    int32_t simm    = int32_t(int16_t(opcode));
+    uint32_t uimm   = uint16_t(opcode);
+
+    switch (opcode >> 26) {
+    case 7: // mulli
+        a.imul_mem_imm(RAX, REG_STATE, gpr_offs(reg_a), simm);
+        store_gpr(reg_d, RAX);
+        break;
+    case 10: // cmpli
+    case 11: // cmpi
+        if (opcode & 0x200000)
+            goto interpret;
+        load_gpr(RAX, reg_a);
+        if ((opcode >> 26) == 10) {
+            a.alu_imm(ALU_CMP, RAX, uimm);
+            emit_cr_update(reg_d & 0x1C, CC_B, CC_A);
+        } else {
+            a.alu_imm(ALU_CMP, RAX, simm);
+            emit_cr_update(reg_d & 0x1C, CC_L, CC_G);
+        }
+        break;
+    case 12: // addic
+    case 13: // addic.
+        load_gpr(RAX, reg_a);
+        a.alu_imm(ALU_ADD, RAX, simm);
+        emit_set_ca(CC_C);
+        store_gpr(reg_d, RAX);
+        if ((opcode >> 26) == 13)
+            emit_cr0_update();
+        break;
+    case 14: // addi
+    case 15: // addis
+    {
+        uint32_t imm = ((opcode >> 26) == 15) ? (uint32_t)simm << 16 : (uint32_t)simm;
+        if (reg_a) {
+            load_gpr(RAX, reg_a);
+            if (imm)
+                a.alu_imm(ALU_ADD, RAX, imm);
+        } else {
+            a.mov_imm(RAX, imm);
+        }
+        store_gpr(reg_d, RAX);
+        break;
+    }
+    case 16: // bc
+        emit_bc(va, opcode);
+        closed = true;
+        return true;
+    case 18: // b
+        emit_b(va, opcode);
+        closed = true;
+        return true;
+    case 19:
+        if (((opcode >> 1) & 0x3FF) != 16)
+            goto interpret;
+        emit_bclr(va, opcode);
+        closed = true;
+        return true;
+    case 21: // rlwinm
+    {
+        unsigned rot_sh = (opcode >> 11) & 0x1F;
+        load_gpr(RAX, reg_d);
+        if (rot_sh)
+            a.shift_imm(SH_ROL, RAX, rot_sh);
+        a.alu_imm(ALU_AND, RAX, rot_mask((opcode >> 6) & 0x1F, (opcode >> 1) & 0x1F));
+        store_gpr(reg_a, RAX);
+        if (opcode & 1)
+            emit_cr0_update();
+        break;
+    }
+    case 24: // ori
+    case 25: // oris
+    case 26: // xori
+    case 27: // xoris
+    case 28: // andi.
+    case 29: // andis.
+    {
+        uint32_t imm = (opcode & (1 << 26)) ? uimm << 16 : uimm;
+        load_gpr(RAX, reg_d);
+        switch (opcode >> 27) {
+        case 12:
+            a.alu_imm(ALU_OR, RAX, imm);
+            break;
+        case 13:
+            a.alu_imm(ALU_XOR, RAX, imm);
+            break;
+        default:
+            a.alu_imm(ALU_AND, RAX, imm);
+        }
+        store_gpr(reg_a, RAX);
+        if ((opcode >> 27) == 14)
+            emit_cr0_update();
+        break;
+    }
+    case 31:
+        if (!emit_opcode31(opcode))
+            goto interpret;
+        break;
+    case 32: // lwz
+    case 34: // lbz
+    case 40: // lhz
+        emit_load(va, opcode, ls_size(opcode), false);
+        return false;
+    case 33: // lwzu
+    case 35: // lbzu
+    case 41: // lhzu
+        if (!reg_a || reg_a == reg_d)
+            goto interpret;
+        emit_load(va, opcode, ls_size(opcode), true);
+        return false;
+    case 36: // stw
+    case 38: // stb
+    case 44: // sth
+        emit_store(va, opcode, ls_size(opcode), false);
+        return false;
+    case 37: // stwu
+    case 39: // stbu
+    case 45: // sthu
+        if (!reg_a)
+            goto interpret;
+        emit_store(va, opcode, ls_size(opcode), true);
+        return false;
+    default:
+        goto interpret;
+    }
+
+    pending++;
+    return false;
+
+interpret:
+    // fused slots are translated one instruction at a time
+    emit_interp_call(va, opcode, (slot->flags & DC_FLAG_FUSED) ? ppc_decode_opcode(opcode)
+                                                                : slot->handler);
+
+    switch (opcode >> 26) {
+    case 17: // sc
+        return true;
+    case 19:
+        switch ((opcode >> 1) & 0x3FF) {
+        case 50:  // rfi
+        case 150: // isync
+        case 528: // bcctr
+            return true;
+        }
+    }
+    return false;
+}
+
+JitCode JitCompiler::compile(uint32_t va, uint32_t phys, DecodedInstr* slot, const uint8_t* host_va) {
+    JitCode code = (JitCode)a.pos();
+    uint32_t last_va;
+    bool     terminated = false;
+
+    block_va   = va;
+    block_phys = phys;
+    closed     = false;
+
+    emit_prologue();
+    body = a.pos();
+
+    for (uint32_t i = 0; i < JIT_MAX_BLOCK_INSTRS; i++) {
+        if (!slot->handler)
+            decode_cache_fill(slot, host_va);
+        slot->flags |= DC_FLAG_JIT;
+
+        last_va = va;
+        if (compile_instr(va, slot)) {
+            terminated = true;
+            break;
+        }
+        if ((va & ~PPC_PAGE_MASK) == (PPC_PAGE_SIZE - 4))
+            break; // stay within one page
+        if (a.size() > JIT_MAX_BLOCK_BYTES - 1024)
+            break;
+
+        va += 4;
+        host_va += 4;
+        slot++;
+    }
+
+    if (closed) {
+        // branch exits are emitted already
+    } else if (terminated) {
+        a.store32_imm(REG_STATE, PC_OFFS, last_va);
+        add_cycles(pending);
+    } else {
+        // block got too long, continue with the next instruction
+        emit_chain_exit(last_va + 4, last_va, pending);
+    }
+    emit_epilogue();
+
+    return code;
+}
+
+/* ----------------------------- public API ------------------------------ */
+
+bool ppc_jit_init()
+{
+    if (!code_buf) {
+        void* buf = mmap(nullptr, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buf == MAP_FAILED) {
+            LOG_F(ERROR, "JIT: could not allocate code buffer");
+            return false;
+        }
+        code_buf = (uint8_t*)buf;
+    }
+
+    jit_enabled = true;
+    ppc_jit_flush();
+
+    LOG_F(INFO, "JIT: x86-64 recompiler enabled");
+    return true;
+}
+
+JitCode ppc_jit_lookup(uint32_t guest_va, uint32_t phys_addr, const uint8_t* host_va)
+{
+    JitEntry* e  = &jit_table[(phys_addr >> 2) & (JIT_TABLE_SIZE - 1)];
+    uint8_t  gen = jit_page_gen[phys_addr >> 12];
+
+    JitLink* link = jit_exit_link;
+    jit_exit_link = nullptr;
+
+    if (e->phys != phys_addr || e->va != guest_va || e->gen != gen) {
+        e->phys  = phys_addr;
+        e->va    = guest_va;
+        e->gen   = gen;
+        e->count = 0;
+        e->code  = nullptr;
+        e->body  = nullptr;
+    }
+
+    if (e->code) {
+        // the previous block branched here, chain it to this one
+        if (link && link->phys == phys_addr && link->va == guest_va)
+            link->body = e->body;
+        return e->code;
+    }
+
+    if (++e->count < JIT_HOT_THRESHOLD || gen >= JIT_MAX_PAGE_GEN)
+        return nullptr;
+
+    // fetching the slots may flush the decode cache and all blocks with it
+    DecodedInstr* slot = &decode_cache_get_page(phys_addr)[(phys_addr & 0xFFF) >> 2];
+    if (e->phys != phys_addr)
+        return nullptr;
+
+    // idle loops are left to the interpreter which fast-forwards them
+    if (idle_skip_enabled && ppc_idle_loop_head(guest_va, slot, host_va))
+        return nullptr;
+
+    if (code_ptr + JIT_MAX_BLOCK_BYTES > code_buf + JIT_CODE_SIZE) {
+        LOG_F(9, "JIT: code buffer full, flushing");
+        ppc_jit_flush();
+        return nullptr;
+    }
+
+    JitCompiler compiler(code_ptr);
+    e->code  = compiler.compile(guest_va, phys_addr, slot, host_va);
+    e->body  = compiler.code_body();
+    code_ptr = compiler.code_end();
+
+    return e->code;
+}
+
+void ppc_jit_invalidate_page(uint32_t phys_addr)
+{
+    uint8_t& gen = jit_page_gen[phys_addr >> 12];
+    if (gen < 255)
+        gen++;
+    jit_block_stale = true;
+}
+
+void ppc_jit_flush()
+{
+    for (auto& e : jit_table) {
+        e.phys = 1;
+        e.code = nullptr;
+        e.body = nullptr;
+    }
+    jit_exit_link = nullptr;
+    std::memset(jit_page_gen, 0, sizeof(jit_page_gen));
+    code_ptr = code_buf;
+}
+
+#else // no JIT support for this host
+
+bool ppc_jit_init()
+{
+    LOG_F(WARNING, "JIT: not supported on this host");
+    return false;
+}
+
+JitCode ppc_jit_lookup(uint32_t guest_va, uint32_t phys_addr, const uint8_t* host_va)
+{
+    return nullptr;
+}
+
+void ppc_jit_invalidate_page(uint32_t phys_addr)
+{
+}
+
+void ppc_jit_flush()
+{
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Dynamic recompiler for hot PowerPC code blocks (x86-64 hosts).
+
+    A block starts at a given guest address and extends up to the next
+    branch or the end of its page. Blocks executed often enough are
+    translated into host code. Integer ALU ops, simple loads/stores and
+    branches are emitted natively, everything else calls the interpreter
+    handler for that instruction.
+
+    A block returns to the dispatcher with ppc_state.pc pointing to the
+    last executed instruction and exec_flags set by that instruction,
+    just like the interpreter loop does after each instruction.
+
+    Branches to targets within the same page jump directly into the
+    successor block once it has been compiled. Such links live in the
+    code of the branching block and therefore go away together with it.
+ */
+
+#ifndef PPC_JIT_H
+#define PPC_JIT_H
+
+#include <cinttypes>
+
+typedef void (*JitCode)(void);
+
+/** Tells whether the JIT execution mode is active. */
+extern bool jit_enabled;
+
+/** Set when code of the running block has been overwritten. */
+extern bool jit_block_stale;
+
+/** Blocks don't chain into their successors once g_icycles reaches this. */
+extern uint64_t jit_cycle_limit;
+
+/** Set up the code buffer and enable the JIT.
+    Returns false if the host isn't supported. */
+extern bool ppc_jit_init();
+
+/** Return host code for the block at guest_va/phys_addr or nullptr
+    if the block should be interpreted. Compiles hot blocks on the fly. */
+extern JitCode ppc_jit_lookup(uint32_t guest_va, uint32_t phys_addr, const uint8_t* host_va);
+
+/** Discard all blocks in the physical page containing phys_addr. */
+extern void ppc_jit_invalidate_page(uint32_t phys_addr);
+
+/** Discard all translated blocks. */
+extern void ppc_jit_flush();
+
+#endif // PPC_JIT_H
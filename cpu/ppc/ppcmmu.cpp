@@ -22,13 +22,18 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 /** @file PowerPC Memory Management Unit emulation. */
 
 #include <devices/memctrl/memctrlbase.h>
+#include <devices/memctrl/fastmem.h>
 #include <devices/common/mmiodevice.h>
+#include <devices/common/mmiohandlers.h>
 #include <memaccess.h>
 #include "ppcemu.h"
 #include "ppcmmu.h"
+#include "ppcdecodecache.h"
 
+#include <algorithm>
 #include <array>
 #include <cinttypes>
+#include <cstring>
 #include <loguru.hpp>
 #include <stdexcept>
 
@@ -56,6 +61,7 @@ uint64_t    iomem_writes_total = 0; // counts I/O memory writes
 uint64_t    exec_reads_total   = 0; // counts reads from executable memory
 uint64_t    bat_transl_total   = 0; // counts BAT translations
 uint64_t    ptab_transl_total  = 0; // counts page table translations
+uint64_t    ptab_searches_total = 0; // counts page table searches
 uint64_t    unaligned_reads    = 0; // counts unaligned reads
 uint64_t    unaligned_writes   = 0; // counts unaligned writes
 uint64_t    unaligned_crossp_r = 0; // counts unaligned crosspage reads
@@ -73,6 +79,11 @@ uint64_t    num_primary_dtlb_hits   = 0; // number of hits in the primary DTLB
 uint64_t    num_secondary_dtlb_hits = 0; // number of hits in the secondary DTLB
 uint64_t    num_dtlb_refills        = 0; // number of DTLB refills
 uint64_t    num_entry_replacements  = 0; // number of entry replacements
+uint64_t    num_ctx_reuses          = 0; // number of SR loads with resident TLB entries
+uint64_t    num_ctx_allocs          = 0; // number of SR loads requiring a new context
+uint64_t    num_ctx_wraps           = 0; // number of TLB flushes caused by context reuse
+uint64_t    num_block_itlb_hits     = 0; // number of hits in the block ITLB
+uint64_t    num_block_dtlb_hits     = 0; // number of hits in the block DTLB
 
 #endif // TLB_PROFILING
 
@@ -227,10 +238,34 @@ static bool search_pteg(uint8_t* pteg_addr, uint8_t** ret_pte_addr, uint32_t vsi
     return false;
 }
 
+/* Locations of recently used PTEs indexed by the folded primary hash.
+   Secondary TLB misses hitting here don't need to search any PTEG.
+   A hit is only taken if the first word of the PTE still is what it was
+   when the PTE was found. This catches the guest invalidating, replacing
+   or moving the PTE without watching stores into the page table; tlbie
+   doesn't need to drop anything either. The second word isn't cached so
+   changes to it are picked up as well.
+   The cache has to be cleared when SDR1 moves the page table. */
+constexpr uint32_t PTE_CACHE_SIZE = 8192;
+
+typedef struct PTECacheEntry {
+    uint32_t    pte_check; // PTE matching word for the primary PTEG, 0 if unused
+    uint32_t    pte_hi;    // first word of the PTE found for it
+    uint8_t*    pte_addr;  // host address of the PTE
+} PTECacheEntry;
+
+static std::array<PTECacheEntry, PTE_CACHE_SIZE> pte_cache;
+
+static void pte_cache_clear()
+{
+    for (auto& el : pte_cache)
+        el.pte_check = 0;
+}
+
 static PATResult page_address_translation(uint32_t la, bool is_instr_fetch,
                                           unsigned msr_pr, int is_write)
 {
-    uint32_t sr_val, page_index, pteg_hash1, vsid, pte_word2;
+    uint32_t sr_val, page_index, pteg_hash1, vsid, pte_check, pte_word2;
     unsigned key, pp;
     uint8_t* pte_addr;
 
@@ -251,14 +286,32 @@ static PATResult page_address_translation(uint32_t la, bool is_instr_fetch,
     /* instruction fetch from a no-execute segment will cause ISI exception */
     if ((sr_val & 0x10000000) && is_instr_fetch) {
         mmu_exception_handler(Except_Type::EXC_ISI, 0x10000000);
+        return PATResult{0, 0, 0};
     }
 
     page_index = (la >> 12) & 0xFFFF;
     pteg_hash1 = (sr_val & 0x7FFFF) ^ page_index;
     vsid       = sr_val & 0x0FFFFFF;
+    pte_check  = 0x80000000 | (vsid << 7) | (page_index >> 10);
+
+#ifdef MMU_PROFILING
+    ptab_transl_total++;
+#endif
 
-    if (!search_pteg(calc_pteg_addr(pteg_hash1), &pte_addr, vsid, page_index, 0)) {
-        if (!search_pteg(calc_pteg_addr(~pteg_hash1), &pte_addr, vsid, page_index, 1)) {
+    PTECacheEntry* cache_entry = &pte_cache[(pteg_hash1 ^ (pteg_hash1 >> 13)) & (PTE_CACHE_SIZE - 1)];
+
+    if (cache_entry->pte_check == pte_check &&
+        READ_DWORD_BE_A(cache_entry->pte_addr) == cache_entry->pte_hi) {
+        pte_addr = cache_entry->pte_addr;
+    } else {
+#ifdef MMU_PROFILING
+        ptab_searches_total++;
+#endif
+        if (search_pteg(calc_pteg_addr(pteg_hash1), &pte_addr, vsid, page_index, 0)) {
+            cache_entry->pte_hi = pte_check;
+        } else if (search_pteg(calc_pteg_addr(~pteg_hash1), &pte_addr, vsid, page_index, 1)) {
+            cache_entry->pte_hi = pte_check | 0x40; // H bit
+        } else {
             if (is_instr_fetch) {
                 mmu_exception_handler(Except_Type::EXC_ISI, 0x40000000);
             } else {
@@ -266,7 +319,10 @@ static PATResult page_address_translation(uint32_t la, bool is_instr_fetch,
                 ppc_state.spr[SPR::DAR]   = la;
                 mmu_exception_handler(Except_Type::EXC_DSI, 0);
             }
+            return PATResult{0, 0, 0};
         }
+        cache_entry->pte_check = pte_check;
+        cache_entry->pte_addr  = pte_addr;
     }
 
     pte_word2 = READ_DWORD_BE_A(pte_addr + 4);
@@ -288,6 +344,7 @@ static PATResult page_address_translation(uint32_t la, bool is_instr_fetch,
             ppc_state.spr[SPR::DAR]   = la;
             mmu_exception_handler(Except_Type::EXC_DSI, 0);
         }
+        return PATResult{0, 0, 0};
     }
 
     /* update R and C bits */
@@ -305,13 +362,41 @@ static PATResult page_address_translation(uint32_t la, bool is_instr_fetch,
     };
 }
 
+// Map size bytes starting at addr that lie within the region rgn.
+static DmaSegment map_dma_segment(AddressMapEntry* rgn, uint32_t addr, uint32_t size,
+                                  bool allow_mmio) {
+    DmaSegment seg = {addr, size, rgn->type, false, nullptr, nullptr, 0};
+
+    if ((rgn->type & RT_MMIO) && !allow_mmio) {
+        ABORT_F("SOS: DMA access to a MMIO region 0x%08X..0x%08X (%s) for physical memory 0x%08X..0x%08X is not allowed.",
+            rgn->start, rgn->end, rgn->devobj->get_name().c_str(), addr, addr + size - 1
+        );
+    }
+
+    if (rgn->type & (RT_ROM | RT_RAM)) {
+        seg.host_va = rgn->mem_ptr + (addr - rgn->start);
+        seg.is_writable = rgn->type & RT_RAM;
+        if (seg.is_writable) {
+            // DMA may overwrite code we have already decoded
+            decode_cache_invalidate(addr, size);
+            if (rgn->type & RT_VRAM)
+                vram_mark_dirty(addr, size);
+        }
+    } else { // RT_MMIO
+        seg.dev_obj = rgn->devobj;
+        seg.dev_base = rgn->start;
+        seg.is_writable = true; // all MMIO devices must provide a write method
+    }
+
+    return seg;
+}
+
 MapDmaResult mmu_map_dma_mem(uint32_t addr, uint32_t size, bool allow_mmio) {
-    MMIODevice      *devobj  = nullptr;
-    uint8_t         *host_va = nullptr;
-    uint32_t        dev_base = 0;
-    bool            is_writable;
     AddressMapEntry *cur_dma_rgn;
 
+    // DMA may be driven from other threads, e.g. audio playback
+    mem_ctrl_instance->begin_async_lookup();
+
     cur_dma_rgn = mem_ctrl_instance->find_range(addr);
     if (!cur_dma_rgn) {
         ABORT_F("SOS: DMA access to unmapped physical memory 0x%08X..0x%08X!",
@@ -325,22 +410,45 @@ MapDmaResult mmu_map_dma_mem(uint32_t addr, uint32_t size, bool allow_mmio) {
         );
     }
 
-    if ((cur_dma_rgn->type & RT_MMIO) && !allow_mmio) {
-        ABORT_F("SOS: DMA access to a MMIO region 0x%08X..0x%08X (%s) for physical memory 0x%08X..0x%08X is not allowed.",
-            cur_dma_rgn->start, cur_dma_rgn->end, cur_dma_rgn->devobj->get_name().c_str(), addr, addr + size - 1
-        );
-    }
+    DmaSegment seg = map_dma_segment(cur_dma_rgn, addr, size, allow_mmio);
 
-    if (cur_dma_rgn->type & (RT_ROM | RT_RAM)) {
-        host_va  = cur_dma_rgn->mem_ptr + (addr - cur_dma_rgn->start);
-        is_writable = cur_dma_rgn->type & RT_RAM;
-    } else { // RT_MMIO
-        devobj = cur_dma_rgn->devobj;
-        dev_base = cur_dma_rgn->start;
-        is_writable = true; // all MMIO devices must provide a write method
+    mem_ctrl_instance->end_async_lookup();
+
+    return MapDmaResult{seg.type, seg.is_writable, seg.host_va, seg.dev_obj, seg.dev_base};
+}
+
+/** Map a physical range that may span several regions as a list of segments.
+    Adjacent segments that are contiguous in host memory are merged. */
+void mmu_map_dma_sg(uint32_t addr, uint32_t size, bool allow_mmio,
+                    std::vector<DmaSegment>& segs) {
+    segs.clear();
+
+    mem_ctrl_instance->begin_async_lookup();
+
+    while (size) {
+        AddressMapEntry* rgn = mem_ctrl_instance->find_range(addr);
+        if (!rgn) {
+            ABORT_F("SOS: DMA access to unmapped physical memory 0x%08X..0x%08X!",
+                addr, addr + size - 1
+            );
+        }
+
+        uint32_t seg_size = std::min(size, rgn->end - addr + 1);
+        DmaSegment seg    = map_dma_segment(rgn, addr, seg_size, allow_mmio);
+
+        DmaSegment* prev = segs.empty() ? nullptr : &segs.back();
+        if (prev && prev->host_va && prev->host_va + prev->size == seg.host_va &&
+            prev->is_writable == seg.is_writable) {
+            prev->size += seg_size;
+        } else {
+            segs.push_back(seg);
+        }
+
+        addr += seg_size;
+        size -= seg_size;
     }
 
-    return MapDmaResult{cur_dma_rgn->type, is_writable, host_va, devobj, dev_base};
+    mem_ctrl_instance->end_async_lookup();
 }
 
 // primary ITLB for all MMU modes
@@ -377,6 +485,49 @@ TLBEntry    UnmappedMem = {TLB_INVALID_TAG, TLBFlags::PAGE_NOPHYS, 0, 0};
 uint8_t     CurITLBMode = {0xFF}; // current ITLB mode
 uint8_t     CurDTLBMode = {0xFF}; // current DTLB mode
 
+uint8_t*    pFastDMem = nullptr; // fastmem window for untranslated data accesses
+
+/* TLB entries created with address translation enabled carry the number
+   of the context they were made in within the low bits of their tag.
+   Each segment register value (VSID and protection keys) gets its own
+   context so entries of inactive address spaces survive segment register
+   reloads and get reused once the same VSID is loaded again.
+   Flushing is done by handing out new context numbers so that lookups
+   won't match the old entries anymore. Tables for the real addressing mode
+   are never flushed and stay at context 0.
+   0xFFF isn't used as context because it would let page 0xFFFFF000 match
+   TLB_INVALID_TAG. */
+constexpr uint32_t TLB_MAX_CTX      = 0xFFE;
+constexpr uint32_t TLB_CTX_MAP_SIZE = 256;
+
+typedef struct TLBContexts {
+    uint32_t    seg_ctx[16]; // context of each segment
+    uint32_t    next_ctx;    // next context number to be handed out
+    uint32_t    first_ctx;   // contexts below this one have been flushed
+    struct {
+        uint32_t    sr_val;
+        uint32_t    ctx;
+    } map[TLB_CTX_MAP_SIZE]; // contexts of recently used segment register values
+} TLBContexts;
+
+static TLBContexts ITLBCtx; // contexts of ITLB tables with translation enabled
+static TLBContexts DTLBCtx; // contexts of DTLB tables with translation enabled
+
+uint32_t    CurITLBSegCtx[16]; // segment contexts of the current ITLB tables
+uint32_t    CurDTLBSegCtx[16]; // segment contexts of the current DTLB tables
+
+template <const TLBType tlb_type>
+static void tlb_load_cur_ctx()
+{
+    if (tlb_type == TLBType::ITLB) {
+        for (int i = 0; i < 16; i++)
+            CurITLBSegCtx[i] = CurITLBMode ? ITLBCtx.seg_ctx[i] : 0;
+    } else {
+        for (int i = 0; i < 16; i++)
+            CurDTLBSegCtx[i] = CurDTLBMode ? DTLBCtx.seg_ctx[i] : 0;
+    }
+}
+
 void mmu_change_mode()
 {
     uint8_t mmu_mode;
@@ -404,6 +555,7 @@ void mmu_change_mode()
                 break;
         }
         CurITLBMode = mmu_mode;
+        tlb_load_cur_ctx<TLBType::ITLB>();
     }
 
     // then switch DTLB tables
@@ -429,6 +581,10 @@ void mmu_change_mode()
                 break;
         }
         CurDTLBMode = mmu_mode;
+        tlb_load_cur_ctx<TLBType::DTLB>();
+
+        // untranslated data accesses bypass the DTLB if guest physical memory is host-mapped
+        pFastDMem = (!mmu_mode && fastmem_owner() == mem_ctrl_instance) ? fastmem_base : nullptr;
     }
 }
 
@@ -528,12 +684,15 @@ static TLBEntry* itlb2_refill(uint32_t guest_va)
             // only PP = 0 (no access) causes ISI exception
             if (!bat_res.prot) {
                 mmu_exception_handler(Except_Type::EXC_ISI, 0x08000000);
+                return nullptr;
             }
             phys_addr = bat_res.phys;
             flags |= TLBFlags::TLBE_FROM_BAT; // tell the world we come from
         } else {
             // page address translation
             PATResult pat_res = page_address_translation(guest_va, true, !!(ppc_state.msr & MSR::PR), 0);
+            if (ppc_instr_aborted())
+                return nullptr;
             phys_addr = pat_res.phys;
             flags = TLBFlags::TLBE_FROM_PAT; // tell the world we come from
         }
@@ -550,8 +709,10 @@ static TLBEntry* itlb2_refill(uint32_t guest_va)
         // refill the secondary TLB
         const uint32_t tag = guest_va & ~0xFFFUL;
         tlb_entry = tlb2_target_entry<TLBType::ITLB>(tag);
-        tlb_entry->tag = tag;
+        tlb_entry->tag = tag | CurITLBSegCtx[guest_va >> 28];
         tlb_entry->flags = flags | TLBFlags::PAGE_MEM;
+        if (rgn_desc->type & RT_VRAM)
+            tlb_entry->flags |= TLBFlags::PAGE_VRAM;
         tlb_entry->host_va_offs_r = (int64_t)rgn_desc->mem_ptr - guest_va +
                                     (phys_addr - rgn_desc->start);
         tlb_entry->phys_tag = phys_addr & ~0xFFFUL;
@@ -589,6 +750,7 @@ static TLBEntry* dtlb2_refill(uint32_t guest_va, int is_write, bool is_dbg = fal
                 ppc_state.spr[SPR::DSISR] = 0x08000000 | (is_write << 25);
                 ppc_state.spr[SPR::DAR]   = guest_va;
                 mmu_exception_handler(Except_Type::EXC_DSI, 0);
+                return &UnmappedMem;
             }
             phys_addr = bat_res.phys;
             flags = TLBFlags::PTE_SET_C; // prevent PTE.C updates for BAT
@@ -599,6 +761,8 @@ static TLBEntry* dtlb2_refill(uint32_t guest_va, int is_write, bool is_dbg = fal
         } else {
             // page address translation
             PATResult pat_res = page_address_translation(guest_va, false, !!(ppc_state.msr & MSR::PR), is_write);
+            if (ppc_instr_aborted())
+                return &UnmappedMem;
             phys_addr = pat_res.phys;
             flags = TLBFlags::TLBE_FROM_PAT; // tell the world we come from
             if (pat_res.prot <= 2 || pat_res.prot == 6) {
@@ -621,13 +785,15 @@ static TLBEntry* dtlb2_refill(uint32_t guest_va, int is_write, bool is_dbg = fal
     if (rgn_desc) {
         // refill the secondary TLB
         tlb_entry = tlb2_target_entry<TLBType::DTLB>(tag);
-        tlb_entry->tag = tag;
+        tlb_entry->tag = tag | CurDTLBSegCtx[guest_va >> 28];
         if (rgn_desc->type & RT_MMIO) { // MMIO region
             tlb_entry->flags = flags | TLBFlags::PAGE_IO;
             tlb_entry->rgn_desc = rgn_desc;
             tlb_entry->dev_base_va = guest_va - (phys_addr - rgn_desc->start);
         } else { // memory region backed by host memory
             tlb_entry->flags = flags | TLBFlags::PAGE_MEM;
+            if (rgn_desc->type & RT_VRAM)
+                tlb_entry->flags |= TLBFlags::PAGE_VRAM;
             tlb_entry->host_va_offs_r = (int64_t)rgn_desc->mem_ptr - guest_va +
                                         (phys_addr - rgn_desc->start);
             if (rgn_desc->type == RT_ROM) {
@@ -699,6 +865,132 @@ static inline TLBEntry* lookup_secondary_tlb(uint32_t guest_va, uint32_t tag) {
     return tlb_entry;
 }
 
+/* Block TLB: one entry per BAT register pair holding the translation of
+   the whole block, so that pages of BAT-mapped blocks refill the primary
+   TLB directly instead of taking up secondary TLB entries one by one.
+   Only blocks entirely backed by a single host memory region are cached,
+   anything else (MMIO, no access, 601 BATs) goes through the regular
+   refill path. Tables are rebuilt lazily after BAT updates. */
+typedef struct BlockTLBEntry {
+    uint32_t    bepi;         // block effective page index
+    uint32_t    hi_mask;      // mask for high-order logical address bits
+    uint32_t    phys_hi;      // high-order bits of the physical address
+    uint16_t    flags;        // flags of TLB entries for this block, 0 if not cached
+    bool        is_rom;       // writes go to the dummy page
+    int64_t     host_va_offs; // host address minus logical address
+} BlockTLBEntry;
+
+typedef struct BlockTLB {
+    bool            valid; // entries match the current BATs
+    BlockTLBEntry   entries[4];
+} BlockTLB;
+
+static BlockTLB iblock_tlb[2]; // block ITLBs for supervisor and user mode
+static BlockTLB dblock_tlb[2]; // block DTLBs for supervisor and user mode
+
+static TLBEntry BlockTLBHit[2]; // entries produced by block TLB lookups
+
+template <const TLBType tlb_type>
+static void block_tlb_invalidate()
+{
+    BlockTLB* block_tlb = (tlb_type == TLBType::ITLB) ? iblock_tlb : dblock_tlb;
+    block_tlb[0].valid = false;
+    block_tlb[1].valid = false;
+}
+
+template <const TLBType tlb_type>
+static void block_tlb_rebuild(BlockTLB& block_tlb, unsigned msr_pr)
+{
+    PPC_BAT_entry* bat_array = (tlb_type == TLBType::ITLB) ? ibat_array : dbat_array;
+    unsigned access_bits = ((msr_pr ^ 1) << 1) | msr_pr;
+
+    for (int bat_index = 0; bat_index < 4; bat_index++) {
+        PPC_BAT_entry* bat_entry = &bat_array[bat_index];
+        BlockTLBEntry& el        = block_tlb.entries[bat_index];
+
+        el.flags = 0;
+
+        if (is_601 || !(bat_entry->access & access_bits)) {
+            // never matches
+            el.bepi    = 1;
+            el.hi_mask = 0;
+            continue;
+        }
+
+        el.bepi    = bat_entry->bepi;
+        el.hi_mask = bat_entry->hi_mask;
+        el.phys_hi = bat_entry->phys_hi;
+
+        if (!bat_entry->prot)
+            continue; // let the refill code raise the exception
+
+        AddressMapEntry* rgn_desc = mem_ctrl_instance->find_range(bat_entry->phys_hi);
+        if (!rgn_desc || (rgn_desc->type & (RT_MMIO | RT_VRAM)) ||
+            (bat_entry->phys_hi | ~bat_entry->hi_mask) > rgn_desc->end)
+            continue;
+
+        el.is_rom       = rgn_desc->type == RT_ROM;
+        el.host_va_offs = (int64_t)rgn_desc->mem_ptr + (bat_entry->phys_hi - rgn_desc->start) -
+                          bat_entry->bepi;
+
+        if (tlb_type == TLBType::ITLB) {
+            el.flags = TLBFlags::TLBE_FROM_BAT | TLBFlags::PAGE_MEM;
+        } else {
+            el.flags = TLBFlags::PTE_SET_C | TLBFlags::TLBE_FROM_BAT | TLBFlags::PAGE_MEM;
+            if (bat_entry->prot == 2)
+                el.flags |= TLBFlags::PAGE_WRITABLE;
+        }
+    }
+
+    block_tlb.valid = true;
+}
+
+// Look up guest virtual address in the block TLB of the current mode.
+// Returns an entry suitable for refilling the primary TLB or nullptr.
+template <const TLBType tlb_type>
+static inline TLBEntry* lookup_block_tlb(uint32_t guest_va, uint32_t tag)
+{
+    uint8_t mmu_mode = (tlb_type == TLBType::ITLB) ? CurITLBMode : CurDTLBMode;
+
+    if (!(mmu_mode & 2))
+        return nullptr; // no BATs in real addressing mode
+
+    BlockTLB& block_tlb = ((tlb_type == TLBType::ITLB) ? iblock_tlb : dblock_tlb)[mmu_mode & 1];
+    if (!block_tlb.valid)
+        block_tlb_rebuild<tlb_type>(block_tlb, mmu_mode & 1);
+
+    for (auto& el : block_tlb.entries) {
+        if ((guest_va & el.hi_mask) != el.bepi)
+            continue;
+
+        // BATs are searched in order so the first match decides
+        if (!el.flags)
+            return nullptr;
+
+#ifdef TLB_PROFILING
+        if (tlb_type == TLBType::ITLB)
+            num_block_itlb_hits++;
+        else
+            num_block_dtlb_hits++;
+#endif
+
+        TLBEntry* tlb_entry       = &BlockTLBHit[tlb_type];
+        tlb_entry->tag            = tag;
+        tlb_entry->flags          = el.flags;
+        tlb_entry->host_va_offs_r = el.host_va_offs;
+        if (el.is_rom) {
+            // redirect writes to the dummy page for ROM regions
+            tlb_entry->host_va_offs_w = (int64_t)&dummy_page - (guest_va & ~0xFFFUL);
+        } else {
+            tlb_entry->host_va_offs_w = el.host_va_offs;
+        }
+        tlb_entry->phys_tag = (el.phys_hi | (guest_va & ~el.hi_mask)) & ~0xFFFUL;
+        return tlb_entry;
+    }
+
+    return nullptr;
+}
+
 uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr)
 {
     TLBEntry *tlb1_entry, *tlb2_entry;
@@ -708,7 +1000,7 @@ uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr)
     exec_reads_total++;
 #endif
 
-    const uint32_t tag = vaddr & ~0xFFFUL;
+    const uint32_t tag = (vaddr & ~0xFFFUL) | CurITLBSegCtx[vaddr >> 28];
 
     // look up guest virtual address in the primary ITLB
     tlb1_entry = &pCurITLB1[(vaddr >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
@@ -718,8 +1010,10 @@ uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr)
 #endif
         host_va = (uint8_t *)(tlb1_entry->host_va_offs_r + vaddr);
     } else {
-        // primary ITLB miss -> look up address in the secondary ITLB
-        tlb2_entry = lookup_secondary_tlb<TLBType::ITLB>(vaddr, tag);
+        // primary ITLB miss -> look up address in the block and secondary ITLBs
+        tlb2_entry = lookup_block_tlb<TLBType::ITLB>(vaddr, tag);
+        if (tlb2_entry == nullptr)
+            tlb2_entry = lookup_secondary_tlb<TLBType::ITLB>(vaddr, tag);
         if (tlb2_entry == nullptr) {
 #ifdef TLB_PROFILING
             num_itlb_refills++;
@@ -727,6 +1021,8 @@ uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr)
             // secondary ITLB miss ->
             // perform full address translation and refill the secondary ITLB
             tlb2_entry = itlb2_refill(vaddr);
+            if (tlb2_entry == nullptr)
+                return nullptr; // ISI exception has been raised
         }
 #ifdef TLB_PROFILING
         else {
@@ -751,7 +1047,7 @@ uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr)
 static void tlb_flush_primary_entry(std::array<TLBEntry, TLB_SIZE> &tlb1, uint32_t tag)
 {
     TLBEntry *tlb_entry = &tlb1[(tag >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
-    if (tlb_entry->tag == tag) {
+    if ((tlb_entry->tag & ~0xFFFUL) == tag) {
         tlb_entry->tag = TLB_INVALID_TAG;
         //LOG_F(INFO, "Invalidated primary TLB entry at 0x%X", ea);
     }
@@ -761,7 +1057,7 @@ static void tlb_flush_secondary_entry(std::array<TLBEntry, TLB_SIZE*TLB2_WAYS> &
 {
     TLBEntry *tlb_entry = &tlb2[((tag >> PPC_PAGE_SIZE_BITS) & tlb_size_mask) * TLB2_WAYS];
     for (int i = 0; i < TLB2_WAYS; i++) {
-        if (tlb_entry[i].tag == tag) {
+        if ((tlb_entry[i].tag & ~0xFFFUL) == tag) {
             tlb_entry[i].tag = TLB_INVALID_TAG;
             //LOG_F(INFO, "Invalidated secondary TLB entry at 0x%X", ea);
         }
@@ -785,6 +1081,24 @@ void tlb_flush_entry(uint32_t ea)
     tlb_flush_secondary_entry(dtlb2_mode3, tag);
 }
 
+void mmu_invalidate_icache_block(uint32_t ea)
+{
+    const uint32_t tag = (ea & ~0xFFFUL) | CurITLBSegCtx[ea >> 28];
+
+    // stores to code pages are tracked by physical address already,
+    // so we only need to take care of pages reachable via the current ITLB
+    TLBEntry *tlb_entry = &pCurITLB1[(ea >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
+    if (tlb_entry->tag != tag) {
+        tlb_entry = lookup_block_tlb<TLBType::ITLB>(ea, tag);
+        if (tlb_entry == nullptr)
+            tlb_entry = lookup_secondary_tlb<TLBType::ITLB>(ea, tag);
+        if (tlb_entry == nullptr)
+            return;
+    }
+
+    decode_cache_invalidate(tlb_entry->phys_tag | (ea & 0xFE0UL), 32);
+}
+
 template <std::size_t N>
 static void tlb_flush_entries(std::array<TLBEntry, N> &tlb, TLBFlags type) {
     for (auto &tlb_el : tlb) {
@@ -797,9 +1111,6 @@ static void tlb_flush_entries(std::array<TLBEntry, N> &tlb, TLBFlags type) {
 template <const TLBType tlb_type>
 void tlb_flush_entries(TLBFlags type)
 {
-    TLBEntry *m1_tlb, *m2_tlb, *m3_tlb;
-    int i;
-
     if (tlb_type == TLBType::ITLB) {
         tlb_flush_entries(itlb1_mode1, type);
         tlb_flush_entries(itlb1_mode2, type);
@@ -817,6 +1128,79 @@ void tlb_flush_entries(TLBFlags type)
     }
 }
 
+// Look up the context of a segment register value, assign a new one if needed.
+static uint32_t tlb_get_ctx(TLBContexts& ctxs, uint32_t sr_val)
+{
+    auto& el = ctxs.map[(sr_val ^ (sr_val >> 8) ^ (sr_val >> 16)) & (TLB_CTX_MAP_SIZE - 1)];
+
+    if (el.ctx < ctxs.first_ctx || el.sr_val != sr_val) {
+        el.sr_val = sr_val;
+        el.ctx    = ctxs.next_ctx++;
+    }
+
+    return el.ctx;
+}
+
+// Retire all entries created with translation enabled.
+// This includes BAT entries when only the page translation context changed
+// but these are cheap to recreate.
+template <const TLBType tlb_type>
+static void tlb_flush_contexts()
+{
+    TLBContexts& ctxs = (tlb_type == TLBType::ITLB) ? ITLBCtx : DTLBCtx;
+
+    if (ctxs.next_ctx + 16 > TLB_MAX_CTX + 1) {
+        // context numbers are going to be reused so old entries must go for real
+        tlb_flush_entries<tlb_type>((TLBFlags)(TLBE_FROM_BAT | TLBE_FROM_PAT));
+        for (auto& el : ctxs.map)
+            el.ctx = 0;
+        ctxs.next_ctx = 1;
+#ifdef TLB_PROFILING
+        num_ctx_wraps++;
+#endif
+    }
+
+    ctxs.first_ctx = ctxs.next_ctx;
+
+    for (int i = 0; i < 16; i++)
+        ctxs.seg_ctx[i] = tlb_get_ctx(ctxs, ppc_state.sr[i]);
+
+    tlb_load_cur_ctx<tlb_type>();
+}
+
+// Switch a segment to the context of its new segment register value.
+template <const TLBType tlb_type>
+static void tlb_load_segment_ctx(uint32_t sr_num)
+{
+    TLBContexts& ctxs = (tlb_type == TLBType::ITLB) ? ITLBCtx : DTLBCtx;
+
+    if (ctxs.next_ctx > TLB_MAX_CTX) {
+        tlb_flush_contexts<tlb_type>();
+        return;
+    }
+
+#ifdef TLB_PROFILING
+    uint32_t next_ctx = ctxs.next_ctx;
+#endif
+
+    ctxs.seg_ctx[sr_num] = tlb_get_ctx(ctxs, ppc_state.sr[sr_num]);
+
+#ifdef TLB_PROFILING
+    if (ctxs.next_ctx == next_ctx)
+        num_ctx_reuses++;
+    else
+        num_ctx_allocs++;
+#endif
+
+    if (tlb_type == TLBType::ITLB) {
+        if (CurITLBMode)
+            CurITLBSegCtx[sr_num] = ctxs.seg_ctx[sr_num];
+    } else {
+        if (CurDTLBMode)
+            CurDTLBSegCtx[sr_num] = ctxs.seg_ctx[sr_num];
+    }
+}
+
 bool gTLBFlushIBatEntries = false;
 bool gTLBFlushDBatEntries = false;
 bool gTLBFlushIPatEntries = false;
@@ -828,12 +1212,12 @@ void tlb_flush_bat_entries()
     if (tlb_type == TLBType::ITLB) {
         if (!gTLBFlushIBatEntries)
             return;
-        tlb_flush_entries<TLBType::ITLB>(TLBE_FROM_BAT);
+        tlb_flush_contexts<TLBType::ITLB>();
         gTLBFlushIBatEntries = false;
     } else {
         if (!gTLBFlushDBatEntries)
             return;
-        tlb_flush_entries<TLBType::DTLB>(TLBE_FROM_BAT);
+        tlb_flush_contexts<TLBType::DTLB>();
         gTLBFlushDBatEntries = false;
     }
 }
@@ -844,12 +1228,12 @@ void tlb_flush_pat_entries()
     if (tlb_type == TLBType::ITLB) {
         if (!gTLBFlushIPatEntries)
             return;
-        tlb_flush_entries<TLBType::ITLB>(TLBE_FROM_PAT);
+        tlb_flush_contexts<TLBType::ITLB>();
         gTLBFlushIPatEntries = false;
     } else {
         if (!gTLBFlushDPatEntries)
             return;
-        tlb_flush_entries<TLBType::DTLB>(TLBE_FROM_PAT);
+        tlb_flush_contexts<TLBType::DTLB>();
         gTLBFlushDPatEntries = false;
     }
 }
@@ -860,18 +1244,26 @@ void tlb_flush_all_entries()
     if (tlb_type == TLBType::ITLB) {
         if (!gTLBFlushIBatEntries && !gTLBFlushIPatEntries)
             return;
-        tlb_flush_entries<TLBType::ITLB>((TLBFlags)(TLBE_FROM_BAT | TLBE_FROM_PAT));
+        tlb_flush_contexts<TLBType::ITLB>();
         gTLBFlushIBatEntries = false;
         gTLBFlushIPatEntries = false;
     } else {
         if (!gTLBFlushDBatEntries && !gTLBFlushDPatEntries)
             return;
-        tlb_flush_entries<TLBType::DTLB>((TLBFlags)(TLBE_FROM_BAT | TLBE_FROM_PAT));
+        tlb_flush_contexts<TLBType::DTLB>();
         gTLBFlushDBatEntries = false;
         gTLBFlushDPatEntries = false;
     }
 }
 
+// Drop TLB entries of MMIO and video memory pages.
+// Needed after VRAM has been mapped over or unmapped from MMIO regions.
+void tlb_flush_device_entries()
+{
+    tlb_flush_entries<TLBType::ITLB>(TLBFlags::PAGE_VRAM);
+    tlb_flush_entries<TLBType::DTLB>((TLBFlags)(TLBFlags::PAGE_IO | TLBFlags::PAGE_VRAM));
+}
+
 static void mpc601_bat_update(uint32_t bat_reg)
 {
     PPC_BAT_entry *ibat_entry, *dbat_entry;
@@ -931,6 +1323,8 @@ static void ppc_ibat_update(uint32_t bat_reg)
     bat_entry->phys_hi = ppc_state.spr[upper_reg_num + 1] & hi_mask;
     bat_entry->bepi    = ppc_state.spr[upper_reg_num] & hi_mask;
 
+    block_tlb_invalidate<TLBType::ITLB>();
+
     if (!gTLBFlushIBatEntries || !gTLBFlushIPatEntries) {
         gTLBFlushIBatEntries = true;
         gTLBFlushIPatEntries = true;
@@ -956,6 +1350,8 @@ static void ppc_dbat_update(uint32_t bat_reg)
     bat_entry->phys_hi = ppc_state.spr[upper_reg_num + 1] & hi_mask;
     bat_entry->bepi    = ppc_state.spr[upper_reg_num] & hi_mask;
 
+    block_tlb_invalidate<TLBType::DTLB>();
+
     if (!gTLBFlushDBatEntries || !gTLBFlushDPatEntries) {
         gTLBFlushDBatEntries = true;
         gTLBFlushDPatEntries = true;
@@ -964,8 +1360,19 @@ static void ppc_dbat_update(uint32_t bat_reg)
 
 }
 
+void mmu_sr_changed(uint32_t sr_num)
+{
+    // entries of the previous segment register value stay in the TLB
+    // and will be found again once that value is reloaded
+    tlb_load_segment_ctx<TLBType::ITLB>(sr_num);
+    tlb_load_segment_ctx<TLBType::DTLB>(sr_num);
+}
+
 void mmu_pat_ctx_changed()
 {
+    // cached PTE locations point into the old page table
+    pte_cache_clear();
+
     // Page address translation context changed so we need to flush
     // all PAT entries from both ITLB and DTLB
     if (!gTLBFlushIPatEntries || !gTLBFlushDPatEntries) {
@@ -988,7 +1395,14 @@ inline T mmu_read_vmem(uint32_t guest_va)
     TLBEntry *tlb1_entry, *tlb2_entry;
     uint8_t *host_va;
 
-    const uint32_t tag = guest_va & ~0xFFFUL;
+#ifdef HAVE_FASTMEM
+    // MMIO and unmapped space keep going through the DTLB
+    if (pFastDMem && !(guest_va & (sizeof(T) - 1)) && fastmem_is_mem_page(guest_va)) {
+        return fastmem_load<T>(pFastDMem, guest_va);
+    }
+#endif
+
+    const uint32_t tag = (guest_va & ~0xFFFUL) | CurDTLBSegCtx[guest_va >> 28];
 
     // look up guest virtual address in the primary TLB
     tlb1_entry = &pCurDTLB1[(guest_va >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
@@ -998,8 +1412,10 @@ inline T mmu_read_vmem(uint32_t guest_va)
 #endif
         host_va = (uint8_t *)(tlb1_entry->host_va_offs_r + guest_va);
     } else {
-        // primary TLB miss -> look up address in the secondary TLB
-        tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
+        // primary TLB miss -> look up address in the block and secondary TLBs
+        tlb2_entry = lookup_block_tlb<TLBType::DTLB>(guest_va, tag);
+        if (tlb2_entry == nullptr)
+            tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
         if (tlb2_entry == nullptr) {
 #ifdef TLB_PROFILING
             num_dtlb_refills++;
@@ -1026,23 +1442,25 @@ inline T mmu_read_vmem(uint32_t guest_va)
             iomem_reads_total++;
 #endif
             if (sizeof(T) == 8) {
-                if (guest_va & 3)
+                if (guest_va & 3) {
                     ppc_alignment_exception(guest_va);
+                    return 0;
+                }
 
                 return (
-                    ((T)tlb2_entry->rgn_desc->devobj->read(tlb2_entry->rgn_desc->start,
-                                                           static_cast<uint32_t>(guest_va - tlb2_entry->dev_base_va),
-                                                           4) << 32) |
-                    tlb2_entry->rgn_desc->devobj->read(tlb2_entry->rgn_desc->start,
-                                                       static_cast<uint32_t>(guest_va + 4 - tlb2_entry->dev_base_va),
-                                                       4)
+                    ((T)mmio_read(tlb2_entry->rgn_desc,
+                                  static_cast<uint32_t>(guest_va - tlb2_entry->dev_base_va),
+                                  4) << 32) |
+                    mmio_read(tlb2_entry->rgn_desc,
+                              static_cast<uint32_t>(guest_va + 4 - tlb2_entry->dev_base_va),
+                              4)
                 );
             }
             else {
                 return (
-                    tlb2_entry->rgn_desc->devobj->read(tlb2_entry->rgn_desc->start,
-                                                       static_cast<uint32_t>(guest_va - tlb2_entry->dev_base_va),
-                                                       sizeof(T))
+                    mmio_read(tlb2_entry->rgn_desc,
+                              static_cast<uint32_t>(guest_va - tlb2_entry->dev_base_va),
+                              sizeof(T))
                 );
             }
         }
@@ -1082,7 +1500,16 @@ inline void mmu_write_vmem(uint32_t guest_va, T value)
     TLBEntry *tlb1_entry, *tlb2_entry;
     uint8_t *host_va;
 
-    const uint32_t tag = guest_va & ~0xFFFUL;
+#ifdef HAVE_FASTMEM
+    // ROM writes are dropped by the fastmem fault handler
+    if (pFastDMem && !(guest_va & (sizeof(T) - 1)) && fastmem_is_mem_page(guest_va)) {
+        decode_cache_notify_write(guest_va, sizeof(T));
+        fastmem_store<T>(pFastDMem, guest_va, value);
+        return;
+    }
+#endif
+
+    const uint32_t tag = (guest_va & ~0xFFFUL) | CurDTLBSegCtx[guest_va >> 28];
 
     // look up guest virtual address in the primary TLB
     tlb1_entry = &pCurDTLB1[(guest_va >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
@@ -1094,10 +1521,13 @@ inline void mmu_write_vmem(uint32_t guest_va, T value)
             ppc_state.spr[SPR::DSISR] = 0x08000000 | (1 << 25);
             ppc_state.spr[SPR::DAR]   = guest_va;
             mmu_exception_handler(Except_Type::EXC_DSI, 0);
+            return;
         }
         if (!(tlb1_entry->flags & TLBFlags::PTE_SET_C)) {
             // perform full page address translation to update PTE.C bit
             page_address_translation(guest_va, false, !!(ppc_state.msr & MSR::PR), true);
+            if (ppc_instr_aborted())
+                return;
             tlb1_entry->flags |= TLBFlags::PTE_SET_C;
 
             // don't forget to update the secondary TLB as well
@@ -1108,8 +1538,10 @@ inline void mmu_write_vmem(uint32_t guest_va, T value)
         }
         host_va = (uint8_t *)(tlb1_entry->host_va_offs_w + guest_va);
     } else {
-        // primary TLB miss -> look up address in the secondary TLB
-        tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
+        // primary TLB miss -> look up address in the block and secondary TLBs
+        tlb2_entry = lookup_block_tlb<TLBType::DTLB>(guest_va, tag);
+        if (tlb2_entry == nullptr)
+            tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
         if (tlb2_entry == nullptr) {
 #ifdef TLB_PROFILING
             num_dtlb_refills++;
@@ -1131,11 +1563,14 @@ inline void mmu_write_vmem(uint32_t guest_va, T value)
             ppc_state.spr[SPR::DSISR] = 0x08000000 | (1 << 25);
             ppc_state.spr[SPR::DAR]   = guest_va;
             mmu_exception_handler(Except_Type::EXC_DSI, 0);
+            return;
         }
 
         if (!(tlb2_entry->flags & TLBFlags::PTE_SET_C)) {
             // perform full page address translation to update PTE.C bit
             page_address_translation(guest_va, false, !!(ppc_state.msr & MSR::PR), true);
+            if (ppc_instr_aborted())
+                return;
             tlb2_entry->flags |= TLBFlags::PTE_SET_C;
         }
 
@@ -1148,19 +1583,21 @@ inline void mmu_write_vmem(uint32_t guest_va, T value)
             iomem_writes_total++;
 #endif
             if (sizeof(T) == 8) {
-                if (guest_va & 3)
+                if (guest_va & 3) {
                     ppc_alignment_exception(guest_va);
+                    return;
+                }
 
-                tlb2_entry->rgn_desc->devobj->write(tlb2_entry->rgn_desc->start,
-                                                    static_cast<uint32_t>(guest_va - tlb2_entry->dev_base_va),
-                                                    value >> 32, 4);
-                tlb2_entry->rgn_desc->devobj->write(tlb2_entry->rgn_desc->start,
-                                                    static_cast<uint32_t>(guest_va + 4 - tlb2_entry->dev_base_va),
-                                                    (uint32_t)value, 4);
+                mmio_write(tlb2_entry->rgn_desc,
+                           static_cast<uint32_t>(guest_va - tlb2_entry->dev_base_va),
+                           value >> 32, 4);
+                mmio_write(tlb2_entry->rgn_desc,
+                           static_cast<uint32_t>(guest_va + 4 - tlb2_entry->dev_base_va),
+                           (uint32_t)value, 4);
             } else {
-                tlb2_entry->rgn_desc->devobj->write(tlb2_entry->rgn_desc->start,
-                                                    static_cast<uint32_t>(guest_va - tlb2_entry->dev_base_va),
-                                                    value, sizeof(T));
+                mmio_write(tlb2_entry->rgn_desc,
+                           static_cast<uint32_t>(guest_va - tlb2_entry->dev_base_va),
+                           value, sizeof(T));
             }
             return;
         }
@@ -1170,6 +1607,11 @@ inline void mmu_write_vmem(uint32_t guest_va, T value)
     dmem_writes_total++;
 #endif
 
+    decode_cache_notify_write(tlb1_entry->phys_tag | (guest_va & 0xFFFUL), sizeof(T));
+
+    if (tlb1_entry->flags & TLBFlags::PAGE_VRAM)
+        vram_mark_dirty(tlb1_entry->phys_tag);
+
     // handle unaligned memory accesses
     if (sizeof(T) > 1 && (guest_va & (sizeof(T) - 1))) {
         write_unaligned<T>(guest_va, host_va, value);
@@ -1205,6 +1647,7 @@ static T read_unaligned(uint32_t guest_va, uint8_t *host_va)
     if ((sizeof(T) == 8) && (guest_va & 3)) {
 #ifndef PPC_TESTS
         ppc_alignment_exception(guest_va);
+        return 0;
 #endif
     }
 
@@ -1215,12 +1658,14 @@ static T read_unaligned(uint32_t guest_va, uint8_t *host_va)
 #ifdef MMU_PROFILING
         unaligned_crossp_r++;
 #endif
-        // Break such a memory access into multiple, bytewise accesses.
-        // Because such accesses suffer a performance penalty, they will be
-        // presumably very rare so don't waste time optimizing the code below.
-        for (int i = 0; i < sizeof(T); guest_va++, i++) {
-            result = (result << 8) | mmu_read_vmem<uint8_t>(guest_va);
-        }
+        uint8_t buf[sizeof(T)];
+
+        mmu_read_vmem_bytes(guest_va, buf, sizeof(T));
+        if (ppc_instr_aborted())
+            return 0;
+
+        for (int i = 0; i < sizeof(T); i++)
+            result = (result << 8) | buf[i];
     } else {
 #ifdef MMU_PROFILING
         unaligned_reads++;
@@ -1250,6 +1695,7 @@ static void write_unaligned(uint32_t guest_va, uint8_t *host_va, T value)
     if ((sizeof(T) == 8) && (guest_va & 3)) {
 #ifndef PPC_TESTS
         ppc_alignment_exception(guest_va);
+        return;
 #endif
     }
 
@@ -1258,15 +1704,12 @@ static void write_unaligned(uint32_t guest_va, uint8_t *host_va, T value)
 #ifdef MMU_PROFILING
         unaligned_crossp_w++;
 #endif
-        // Break such a memory access into multiple, bytewise accesses.
-        // Because such accesses suffer a performance penalty, they will be
-        // presumably very rare so don't waste time optimizing the code below.
+        uint8_t buf[sizeof(T)];
 
-        uint32_t shift = (sizeof(T) - 1) * 8;
+        for (int i = sizeof(T) - 1; i >= 0; i--, value >>= 8)
+            buf[i] = value & 0xFF;
 
-        for (int i = 0; i < sizeof(T); shift -= 8, guest_va++, i++) {
-            mmu_write_vmem<uint8_t>(guest_va, (value >> shift) & 0xFF);
-        }
+        mmu_write_vmem_bytes(guest_va, buf, sizeof(T));
     } else {
 #ifdef MMU_PROFILING
         unaligned_writes++;
@@ -1293,6 +1736,178 @@ template void write_unaligned<uint16_t>(uint32_t guest_va, uint8_t *host_va, uin
 template void write_unaligned<uint32_t>(uint32_t guest_va, uint8_t *host_va, uint32_t value);
 template void write_unaligned<uint64_t>(uint32_t guest_va, uint8_t *host_va, uint64_t value);
 
+// Look up guest_va in the DTLBs for a data access, refilling them as needed.
+// Pages backed by host memory are entered into the primary DTLB as well.
+// Returns nullptr if an exception has been raised.
+static TLBEntry* dtlb_translate(uint32_t guest_va, int is_write)
+{
+    const uint32_t tag = (guest_va & ~0xFFFUL) | CurDTLBSegCtx[guest_va >> 28];
+
+    TLBEntry *tlb1_entry = &pCurDTLB1[(guest_va >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
+    TLBEntry *tlb_entry  = tlb1_entry;
+
+    if (tlb1_entry->tag != tag) {
+        tlb_entry = lookup_block_tlb<TLBType::DTLB>(guest_va, tag);
+        if (tlb_entry == nullptr)
+            tlb_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
+        if (tlb_entry == nullptr) {
+#ifdef TLB_PROFILING
+            num_dtlb_refills++;
+#endif
+            tlb_entry = dtlb2_refill(guest_va, is_write);
+            if (ppc_instr_aborted())
+                return nullptr;
+            if (tlb_entry->flags & PAGE_NOPHYS)
+                return tlb_entry;
+        }
+    }
+
+    if (is_write) {
+        if (!(tlb_entry->flags & TLBFlags::PAGE_WRITABLE)) {
+            ppc_state.spr[SPR::DSISR] = 0x08000000 | (1 << 25);
+            ppc_state.spr[SPR::DAR]   = guest_va;
+            mmu_exception_handler(Except_Type::EXC_DSI, 0);
+            return nullptr;
+        }
+        if (!(tlb_entry->flags & TLBFlags::PTE_SET_C)) {
+            // perform full page address translation to update PTE.C bit
+            page_address_translation(guest_va, false, !!(ppc_state.msr & MSR::PR), true);
+            if (ppc_instr_aborted())
+                return nullptr;
+            tlb_entry->flags |= TLBFlags::PTE_SET_C;
+            if (tlb_entry == tlb1_entry) {
+                TLBEntry *tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
+                if (tlb2_entry != nullptr)
+                    tlb2_entry->flags |= TLBFlags::PTE_SET_C;
+            }
+        }
+    }
+
+    if (tlb_entry != tlb1_entry && (tlb_entry->flags & TLBFlags::PAGE_MEM)) {
+        // refill the primary TLB
+        *tlb1_entry = *tlb_entry;
+        tlb_entry   = tlb1_entry;
+    }
+
+    return tlb_entry;
+}
+
+// Size of the access used for the next chunk of a bulk access
+// that has to be broken into single accesses.
+static inline uint32_t bulk_access_size(uint32_t guest_va, uint32_t size)
+{
+    if (!(guest_va & 3) && size >= 4)
+        return 4;
+    if (!(guest_va & 1) && size >= 2)
+        return 2;
+    return 1;
+}
+
+void mmu_read_vmem_bytes(uint32_t guest_va, uint8_t* dst, uint32_t size)
+{
+    while (size) {
+        uint32_t chunk = std::min(size, 0x1000 - (guest_va & 0xFFF));
+
+#ifdef HAVE_FASTMEM
+        if (pFastDMem && fastmem_is_mem_page(guest_va)) {
+            std::memcpy(dst, pFastDMem + guest_va, chunk);
+            guest_va += chunk;
+            dst      += chunk;
+            size     -= chunk;
+            continue;
+        }
+#endif
+
+        TLBEntry *tlb_entry = dtlb_translate(guest_va, 0);
+        if (tlb_entry == nullptr)
+            return;
+
+        if (tlb_entry->flags & TLBFlags::PAGE_MEM) {
+#ifdef MMU_PROFILING
+            dmem_reads_total++;
+#endif
+            std::memcpy(dst, (uint8_t *)(tlb_entry->host_va_offs_r + guest_va), chunk);
+            guest_va += chunk;
+            dst      += chunk;
+            size     -= chunk;
+            continue;
+        }
+
+        // MMIO or unmapped memory, use naturally aligned single accesses
+        for (uint32_t end = guest_va + chunk; guest_va != end;) {
+            uint32_t acc_size = bulk_access_size(guest_va, end - guest_va);
+            switch (acc_size) {
+            case 4:
+                WRITE_DWORD_BE_U(dst, mmu_read_vmem<uint32_t>(guest_va));
+                break;
+            case 2:
+                WRITE_WORD_BE_U(dst, mmu_read_vmem<uint16_t>(guest_va));
+                break;
+            default:
+                *dst = mmu_read_vmem<uint8_t>(guest_va);
+            }
+            if (ppc_instr_aborted())
+                return;
+            guest_va += acc_size;
+            dst      += acc_size;
+            size     -= acc_size;
+        }
+    }
+}
+
+void mmu_write_vmem_bytes(uint32_t guest_va, const uint8_t* src, uint32_t size)
+{
+    while (size) {
+        uint32_t chunk = std::min(size, 0x1000 - (guest_va & 0xFFF));
+
+        TLBEntry *tlb_entry = dtlb_translate(guest_va, 1);
+        if (tlb_entry == nullptr)
+            return;
+
+        if (tlb_entry->flags & TLBFlags::PAGE_MEM) {
+#ifdef MMU_PROFILING
+            dmem_writes_total++;
+#endif
+            decode_cache_notify_write(tlb_entry->phys_tag | (guest_va & 0xFFFUL), chunk);
+            if (tlb_entry->flags & TLBFlags::PAGE_VRAM)
+                vram_mark_dirty(tlb_entry->phys_tag);
+            if (src)
+                std::memcpy((uint8_t *)(tlb_entry->host_va_offs_w + guest_va), src, chunk);
+            else
+                std::memset((uint8_t *)(tlb_entry->host_va_offs_w + guest_va), 0, chunk);
+            guest_va += chunk;
+            src       = src ? src + chunk : nullptr;
+            size     -= chunk;
+            continue;
+        }
+
+        // MMIO or unmapped memory, use naturally aligned single accesses
+        for (uint32_t end = guest_va + chunk; guest_va != end;) {
+            uint32_t acc_size = bulk_access_size(guest_va, end - guest_va);
+            switch (acc_size) {
+            case 4:
+                mmu_write_vmem<uint32_t>(guest_va, src ? READ_DWORD_BE_U(src) : 0);
+                break;
+            case 2:
+                mmu_write_vmem<uint16_t>(guest_va, src ? READ_WORD_BE_U(src) : 0);
+                break;
+            default:
+                mmu_write_vmem<uint8_t>(guest_va, src ? *src : 0);
+            }
+            if (ppc_instr_aborted())
+                return;
+            guest_va += acc_size;
+            src       = src ? src + acc_size : nullptr;
+            size     -= acc_size;
+        }
+    }
+}
+
+void mmu_zero_vmem(uint32_t guest_va, uint32_t size)
+{
+    mmu_write_vmem_bytes(guest_va, nullptr, size);
+}
+
 
 /* MMU profiling. */
 #ifdef MMU_PROFILING
@@ -1335,6 +1950,10 @@ public:
                         .format = ProfileVarFmt::DEC,
                         .value = ptab_transl_total});
 
+        vars.push_back({.name = "Page Table Searches Total",
+                        .format = ProfileVarFmt::DEC,
+                        .value = ptab_searches_total});
+
         vars.push_back({.name = "Unaligned Reads Total",
                         .format = ProfileVarFmt::DEC,
                         .value = unaligned_reads});
@@ -1360,6 +1979,7 @@ public:
         exec_reads_total   = 0;
         bat_transl_total   = 0;
         ptab_transl_total  = 0;
+        ptab_searches_total = 0;
         unaligned_reads    = 0;
         unaligned_writes   = 0;
         unaligned_crossp_r = 0;
@@ -1408,6 +2028,26 @@ public:
         vars.push_back({.name = "Number of replaced TLB entries",
             .format = ProfileVarFmt::DEC,
             .value = num_entry_replacements});
+
+        vars.push_back({.name = "Number of SR loads reusing TLB entries",
+            .format = ProfileVarFmt::DEC,
+            .value = num_ctx_reuses});
+
+        vars.push_back({.name = "Number of SR loads needing a new context",
+            .format = ProfileVarFmt::DEC,
+            .value = num_ctx_allocs});
+
+        vars.push_back({.name = "Number of TLB flushes due to context reuse",
+            .format = ProfileVarFmt::DEC,
+            .value = num_ctx_wraps});
+
+        vars.push_back({.name = "Number of hits in the block ITLB",
+            .format = ProfileVarFmt::DEC,
+            .value = num_block_itlb_hits});
+
+        vars.push_back({.name = "Number of hits in the block DTLB",
+            .format = ProfileVarFmt::DEC,
+            .value = num_block_dtlb_hits});
     };
 
     void reset() {
@@ -1415,6 +2055,11 @@ public:
         num_secondary_dtlb_hits = 0;
         num_dtlb_refills        = 0;
         num_entry_replacements = 0;
+        num_ctx_reuses         = 0;
+        num_ctx_allocs         = 0;
+        num_ctx_wraps          = 0;
+        num_block_itlb_hits    = 0;
+        num_block_dtlb_hits    = 0;
     };
 };
 #endif
@@ -1475,15 +2120,17 @@ bool mmu_translate_dbg(uint32_t guest_va, uint32_t &guest_pa) {
     try {
         TLBEntry *tlb1_entry, *tlb2_entry;
 
-        const uint32_t tag = guest_va & ~0xFFFUL;
+        const uint32_t tag = (guest_va & ~0xFFFUL) | CurDTLBSegCtx[guest_va >> 28];
 
         // look up guest virtual address in the primary TLB
         tlb1_entry = &pCurDTLB1[(guest_va >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
 
         do {
             if (tlb1_entry->tag != tag) {
-                // primary TLB miss -> look up address in the secondary TLB
-                tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
+                // primary TLB miss -> look up address in the block and secondary TLBs
+                tlb2_entry = lookup_block_tlb<TLBType::DTLB>(guest_va, tag);
+                if (tlb2_entry == nullptr)
+                    tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
                 if (tlb2_entry == nullptr) {
                     // secondary TLB miss ->
                     // perform full address translation and refill the secondary TLB
@@ -1564,6 +2211,23 @@ void ppc_mmu_init()
     invalidate_tlb_entries(dtlb2_mode2);
     invalidate_tlb_entries(dtlb2_mode3);
 
+    block_tlb_invalidate<TLBType::ITLB>();
+    block_tlb_invalidate<TLBType::DTLB>();
+    pte_cache_clear();
+
+    // make mmu_change_mode() set up everything for the new memory controller
+    CurITLBMode = 0xFF;
+    CurDTLBMode = 0xFF;
+
+    // start over with fresh contexts
+    for (TLBContexts* ctxs : {&ITLBCtx, &DTLBCtx}) {
+        for (auto& el : ctxs->map)
+            el.ctx = 0;
+        ctxs->next_ctx = 1;
+    }
+    tlb_flush_contexts<TLBType::ITLB>();
+    tlb_flush_contexts<TLBType::DTLB>();
+
     mmu_change_mode();
 
 #ifdef MMU_PROFILING
@@ -28,6 +28,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <cinttypes>
 #include <functional>
+#include <vector>
 
 class MMIODevice;
 
@@ -81,6 +82,19 @@ typedef struct MapDmaResult {
     uint32_t    dev_base;
 } MapDmaResult;
 
+/** Part of a DMA transfer lying within a single physical memory region. */
+typedef struct DmaSegment {
+    uint32_t    phys_addr;
+    uint32_t    size;
+    uint32_t    type;
+    bool        is_writable;
+    // for memory regions
+    uint8_t*    host_va;
+    // for MMIO regions
+    MMIODevice* dev_obj;
+    uint32_t    dev_base;
+} DmaSegment;
+
 constexpr uint32_t PPC_PAGE_SIZE_BITS = 12;
 constexpr uint32_t PPC_PAGE_SIZE      = (1 << PPC_PAGE_SIZE_BITS);
 constexpr uint32_t PPC_PAGE_MASK      = ~(PPC_PAGE_SIZE - 1);
@@ -114,16 +128,26 @@ enum TLBFlags : uint16_t {
     TLBE_FROM_PAT = 1 << 4, // TLB entry has been translated with PAT
     PAGE_WRITABLE = 1 << 5, // page is writable
     PTE_SET_C     = 1 << 6, // tells if C bit of the PTE needs to be updated
+    PAGE_VRAM     = 1 << 7, // video memory page, writes must be tracked
 };
 
+extern TLBEntry* pCurDTLB1; // current primary DTLB
+extern uint8_t*  pFastDMem; // fastmem window for untranslated data accesses
+extern uint32_t  CurDTLBSegCtx[16]; // segment contexts of the current DTLB tables
+
 extern std::function<void(uint32_t bat_reg)> ibat_update;
 extern std::function<void(uint32_t bat_reg)> dbat_update;
 
 extern MapDmaResult mmu_map_dma_mem(uint32_t addr, uint32_t size, bool allow_mmio);
+extern void mmu_map_dma_sg(uint32_t addr, uint32_t size, bool allow_mmio,
+                           std::vector<DmaSegment>& segs);
 
 extern void mmu_change_mode(void);
 extern void mmu_pat_ctx_changed();
+extern void mmu_sr_changed(uint32_t sr_num);
 extern void tlb_flush_entry(uint32_t ea);
+extern void tlb_flush_device_entries();
+extern void mmu_invalidate_icache_block(uint32_t ea);
 
 extern uint64_t mem_read_dbg(uint32_t virt_addr, uint32_t size);
 uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr = nullptr);
@@ -134,6 +158,14 @@ extern T mmu_read_vmem(uint32_t guest_va);
 template <class T>
 extern void mmu_write_vmem(uint32_t guest_va, T value);
 
+/** Bulk accesses to guest virtual memory, translated once per page.
+    Bytes are copied in guest memory order. MMIO is accessed with
+    naturally aligned single accesses of up to 4 bytes.
+    Check ppc_instr_aborted() afterwards, the data may be incomplete. */
+extern void mmu_read_vmem_bytes(uint32_t guest_va, uint8_t* dst, uint32_t size);
+extern void mmu_write_vmem_bytes(uint32_t guest_va, const uint8_t* src, uint32_t size);
+extern void mmu_zero_vmem(uint32_t guest_va, uint32_t size);
+
 //====================== Deprecated calls =========================
 #if 0
 extern void mem_write_byte(uint32_t addr, uint8_t value);
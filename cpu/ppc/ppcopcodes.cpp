@@ -31,14 +31,18 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 //Extract the registers desired and the values of the registers.
 
-// Affects CR Field 0 - For integer operations
-void ppc_changecrf0(uint32_t set_result) {
+bool     cr0_pending;
+uint32_t cr0_result;
+
+// Compute CR0 from the result of the last record-form integer instruction
+void ppc_cr0_materialize() {
+    cr0_pending  = false;
     ppc_state.cr =
         (ppc_state.cr & 0x0FFFFFFFU) // clear CR0
         | (
-            (set_result == 0) ?
+            (cr0_result == 0) ?
                 CRx_bit::CR_EQ
-            : (int32_t(set_result) < 0) ?
+            : (int32_t(cr0_result) < 0) ?
                 CRx_bit::CR_LT
             :
                 CRx_bit::CR_GT
@@ -67,7 +71,7 @@ inline void ppc_carry_sub(uint32_t a, uint32_t b) {
 
 inline void ppc_setsoov(uint32_t a, uint32_t b, uint32_t d) {
     if (int32_t((a ^ b) & (a ^ d)) < 0) {
-        ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+        ppc_xer_overflow();
     } else {
         ppc_state.spr[SPR::XER] &= ~XER::OV;
     }
@@ -288,7 +292,7 @@ void dppc_interpreter::ppc_subfme() {
 
     if (ov) {
         if (ppc_result_d == ppc_result_a && int32_t(ppc_result_d) > 0)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
         else
             ppc_state.spr[SPR::XER] &= ~XER::OV;
     }
@@ -317,7 +321,7 @@ void dppc_interpreter::ppc_subfze() {
 
     if (ov) {
         if (ppc_result_d && ppc_result_d == ppc_result_a)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
         else
             ppc_state.spr[SPR::XER] &= ~XER::OV;
     }
@@ -414,7 +418,7 @@ void dppc_interpreter::ppc_neg() {
 
     if (ov) {
         if (ppc_result_a == 0x80000000)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
         else
             ppc_state.spr[SPR::XER] &= ~XER::OV;
     }
@@ -497,7 +501,7 @@ void dppc_interpreter::ppc_mullw() {
 
     if (ov) {
         if (product != int64_t(int32_t(product))) {
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
         } else {
             ppc_state.spr[SPR::XER] &= ~XER::OV;
         }
@@ -533,13 +537,13 @@ void dppc_interpreter::ppc_divw() {
         // ppc_result_d = (int32_t(ppc_result_a) < 0) ? -1 : 0; /* UNDOCUMENTED! */
 
         if (ov)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
 
     } else if (ppc_result_a == 0x80000000UL && ppc_result_b == 0xFFFFFFFFUL) {
         ppc_result_d = 0; // tested on G4 in Mac OS X 10.4 and Open Firmware.
 
         if (ov)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
+            ppc_xer_overflow();
 
     } else { // normal signed devision
         ppc_result_d = int32_t(ppc_result_a) / int32_t(ppc_result_b);
@@ -568,11 +572,7 @@ void dppc_interpreter::ppc_divwu() {
         ppc_result_d = 0;
 
         if (ov)
-            ppc_state.spr[SPR::XER] |= XER::SO | XER::OV;
-
-        if (rec)
-            ppc_state.cr |= 0x20000000;
-
+            ppc_xer_overflow();
     } else {
         ppc_result_d = ppc_result_a / ppc_result_b;
 
@@ -716,6 +716,7 @@ void dppc_interpreter::ppc_rlwnm() {
 
 void dppc_interpreter::ppc_mfcr() {
     int reg_d            = (ppc_cur_instruction >> 21) & 0x1F;
+    ppc_cr_sync();
     ppc_state.gpr[reg_d] = ppc_state.cr;
 }
 
@@ -725,11 +726,12 @@ void dppc_interpreter::ppc_mtsr() {
 #endif
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
+        return;
     }
     int reg_s             = (ppc_cur_instruction >> 21) & 0x1F;
     uint32_t grab_sr      = (ppc_cur_instruction >> 16) & 0x0F;
     ppc_state.sr[grab_sr] = ppc_state.gpr[reg_s];
-    mmu_pat_ctx_changed();
+    mmu_sr_changed(grab_sr);
 }
 
 void dppc_interpreter::ppc_mtsrin() {
@@ -738,11 +740,12 @@ void dppc_interpreter::ppc_mtsrin() {
 #endif
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
+        return;
     }
     ppc_grab_regssb(ppc_cur_instruction);
     uint32_t grab_sr      = ppc_result_b >> 28;
     ppc_state.sr[grab_sr] = ppc_result_d;
-    mmu_pat_ctx_changed();
+    mmu_sr_changed(grab_sr);
 }
 
 void dppc_interpreter::ppc_mfsr() {
@@ -751,6 +754,7 @@ void dppc_interpreter::ppc_mfsr() {
 #endif
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
+        return;
     }
     int reg_d            = (ppc_cur_instruction >> 21) & 0x1F;
     uint32_t grab_sr     = (ppc_cur_instruction >> 16) & 0x0F;
@@ -763,6 +767,7 @@ void dppc_interpreter::ppc_mfsrin() {
 #endif
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
+        return;
     }
     ppc_grab_regsdb(ppc_cur_instruction);
     uint32_t grab_sr     = ppc_result_b >> 28;
@@ -775,6 +780,7 @@ void dppc_interpreter::ppc_mfmsr() {
 #endif
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
+        return;
     }
     uint32_t reg_d       = (ppc_cur_instruction >> 21) & 0x1F;
     ppc_state.gpr[reg_d] = ppc_state.msr;
@@ -786,6 +792,7 @@ void dppc_interpreter::ppc_mtmsr() {
 #endif
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
+        return;
     }
     uint32_t reg_s = (ppc_cur_instruction >> 21) & 0x1F;
     ppc_state.msr = ppc_state.gpr[reg_s];
@@ -843,7 +850,7 @@ static void update_timebase(uint64_t mask, uint64_t new_val)
 }
 
 
-static uint32_t decrementer_timer_id = 0;
+static uint64_t decrementer_timer_id = 0;
 
 static void trigger_decrementer_exception() {
     decrementer_timer_id = 0;
@@ -880,7 +887,8 @@ static void update_decrementer(uint32_t val) {
     //LOG_F(WARNING, "decrementer:0x%08X ns:%llu", val, time_out);
     decrementer_timer_id = TimerManager::get_instance()->add_oneshot_timer(
         time_out,
-        trigger_decrementer_exception
+        trigger_decrementer_exception,
+        "DEC"
     );
 }
 
@@ -894,6 +902,7 @@ void dppc_interpreter::ppc_mfspr() {
 #endif
         if (ppc_state.msr & MSR::PR) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
+            return;
         }
     }
 
@@ -901,12 +910,14 @@ void dppc_interpreter::ppc_mfspr() {
     case SPR::MQ:
         if (!is_601) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
+            return;
         }
         ppc_state.gpr[reg_d] = ppc_state.spr[ref_spr];
         break;
     case SPR::RTCL_U:
         if (!is_601) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
+            return;
         }
         calc_rtcl_value();
         ppc_state.gpr[reg_d] =
@@ -916,6 +927,7 @@ void dppc_interpreter::ppc_mfspr() {
     case SPR::RTCU_U:
         if (!is_601) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
+            return;
         }
         calc_rtcl_value();
         ppc_state.gpr[reg_d] =
@@ -925,6 +937,7 @@ void dppc_interpreter::ppc_mfspr() {
     case SPR::DEC_U:
         if (!is_601) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
+            return;
         }
         // fallthrough
     case SPR::DEC_S:
@@ -946,6 +959,7 @@ void dppc_interpreter::ppc_mtspr() {
 #endif
         if (ppc_state.msr & MSR::PR) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
+            return;
         }
     }
 
@@ -955,6 +969,7 @@ void dppc_interpreter::ppc_mtspr() {
     case SPR::MQ:
         if (!is_601) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
+            return;
         }
         ppc_state.spr[ref_spr] = val;
         break;
@@ -963,9 +978,11 @@ void dppc_interpreter::ppc_mtspr() {
     case SPR::DEC_U:
         if (!is_601) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
+            return;
         }
         break;
     case SPR::XER:
+        ppc_cr_sync();
         ppc_state.spr[ref_spr] = val & 0xe000ff7f;
         break;
     case SPR::SDR1:
@@ -1065,11 +1082,13 @@ void dppc_interpreter::ppc_mtcrf() {
         if (crm & 0x02) cr_mask |= 0x000000F0UL;
         if (crm & 0x01) cr_mask |= 0x0000000FUL;
     }
+    ppc_cr_sync();
     ppc_state.cr = (ppc_state.cr & ~cr_mask) | (ppc_result_d & cr_mask);
 }
 
 void dppc_interpreter::ppc_mcrxr() {
     int crf_d    = (ppc_cur_instruction >> 21) & 0x1C;
+    ppc_cr_sync();
     ppc_state.cr = (ppc_state.cr & ~(0xF0000000UL >> crf_d)) |
         ((ppc_state.spr[SPR::XER] & 0xF0000000UL) >> crf_d);
     ppc_state.spr[SPR::XER] &= 0x0FFFFFFF;
@@ -1125,6 +1144,8 @@ void dppc_interpreter::ppc_bc() {
         (ppc_state.spr[SPR::CTR])--; /* decrement CTR */
     }
     ctr_ok = (br_bo & 0x04) | ((ppc_state.spr[SPR::CTR] != 0) == !(br_bo & 0x02));
+    if (!(br_bo & 0x10))
+        ppc_cr_sync();
     cnd_ok = (br_bo & 0x10) | (!(ppc_state.cr & (0x80000000UL >> br_bi)) == !(br_bo & 0x08));
 
     if (ctr_ok && cnd_ok) {
@@ -1163,6 +1184,8 @@ void dppc_interpreter::ppc_bcctr() {
         new_ctr = ctr;
     }
     ctr_ok = (br_bo & 0x04) | ((new_ctr != 0) == !(br_bo & 0x02));
+    if (!(br_bo & 0x10))
+        ppc_cr_sync();
     cnd_ok = (br_bo & 0x10) | (!(ppc_state.cr & (0x80000000UL >> br_bi)) == !(br_bo & 0x08));
 
     if (ctr_ok && cnd_ok) {
@@ -1190,6 +1213,8 @@ void dppc_interpreter::ppc_bclr() {
         (ppc_state.spr[SPR::CTR])--; /* decrement CTR */
     }
     ctr_ok = (br_bo & 0x04) | ((ppc_state.spr[SPR::CTR] != 0) == !(br_bo & 0x02));
+    if (!(br_bo & 0x10))
+        ppc_cr_sync();
     cnd_ok = (br_bo & 0x10) | (!(ppc_state.cr & (0x80000000UL >> br_bi)) == !(br_bo & 0x08));
 
     if (ctr_ok && cnd_ok) {
@@ -1217,6 +1242,7 @@ void dppc_interpreter::ppc_cmp() {
     int crf_d = (ppc_cur_instruction >> 21) & 0x1C;
     ppc_grab_regsab(ppc_cur_instruction);
     uint32_t xercon = (ppc_state.spr[SPR::XER] & XER::SO) >> 3;
+    ppc_cr_sync();
     uint32_t cmp_c = (int32_t(ppc_result_a) == int32_t(ppc_result_b)) ? 0x20000000UL : \
         (int32_t(ppc_result_a) > int32_t(ppc_result_b)) ? 0x40000000UL : 0x80000000UL;
     ppc_state.cr = ((ppc_state.cr & ~(0xf0000000UL >> crf_d)) | ((cmp_c + xercon) >> crf_d));
@@ -1233,6 +1259,7 @@ void dppc_interpreter::ppc_cmpi() {
     int crf_d = (ppc_cur_instruction >> 21) & 0x1C;
     ppc_grab_regsasimm(ppc_cur_instruction);
     uint32_t xercon = (ppc_state.spr[SPR::XER] & XER::SO) >> 3;
+    ppc_cr_sync();
     uint32_t cmp_c = (int32_t(ppc_result_a) == simm) ? 0x20000000UL : \
         (int32_t(ppc_result_a) > simm) ? 0x40000000UL : 0x80000000UL;
     ppc_state.cr = ((ppc_state.cr & ~(0xf0000000UL >> crf_d)) | ((cmp_c + xercon) >> crf_d));
@@ -1249,6 +1276,7 @@ void dppc_interpreter::ppc_cmpl() {
     int crf_d = (ppc_cur_instruction >> 21) & 0x1C;
     ppc_grab_regsab(ppc_cur_instruction);
     uint32_t xercon = (ppc_state.spr[SPR::XER] & XER::SO) >> 3;
+    ppc_cr_sync();
     uint32_t cmp_c = (ppc_result_a == ppc_result_b) ? 0x20000000UL : \
         (ppc_result_a > ppc_result_b) ? 0x40000000UL : 0x80000000UL;
     ppc_state.cr = ((ppc_state.cr & ~(0xf0000000UL >> crf_d)) | ((cmp_c + xercon) >> crf_d));
@@ -1263,6 +1291,7 @@ void dppc_interpreter::ppc_cmpli() {
 #endif
     ppc_grab_crfd_regsauimm(ppc_cur_instruction);
     uint32_t xercon = (ppc_state.spr[SPR::XER] & XER::SO) >> 3;
+    ppc_cr_sync();
     uint32_t cmp_c = (ppc_result_a == uimm) ? 0x20000000UL : \
         (ppc_result_a > uimm) ? 0x40000000UL : 0x80000000UL;
     ppc_state.cr = ((ppc_state.cr & ~(0xf0000000UL >> crf_d)) | ((cmp_c + xercon) >> crf_d));
@@ -1274,6 +1303,8 @@ void dppc_interpreter::ppc_mcrf() {
     int crf_d       = (ppc_cur_instruction >> 21) & 0x1C;
     int crf_s       = (ppc_cur_instruction >> 16) & 0x1C;
 
+    ppc_cr_sync();
+
     // extract and right justify source flags field
     uint32_t grab_s = (ppc_state.cr >> (28 - crf_s)) & 0xF;
 
@@ -1282,6 +1313,7 @@ void dppc_interpreter::ppc_mcrf() {
 
 void dppc_interpreter::ppc_crand() {
     ppc_grab_dab(ppc_cur_instruction);
+    ppc_cr_sync();
     uint8_t ir = (ppc_state.cr >> (31 - reg_a)) & (ppc_state.cr >> (31 - reg_b));
     if (ir & 1) {
         ppc_state.cr |= (0x80000000UL >> reg_d);
@@ -1292,6 +1324,7 @@ void dppc_interpreter::ppc_crand() {
 
 void dppc_interpreter::ppc_crandc() {
     ppc_grab_dab(ppc_cur_instruction);
+    ppc_cr_sync();
     if ((ppc_state.cr & (0x80000000UL >> reg_a)) && !(ppc_state.cr & (0x80000000UL >> reg_b))) {
         ppc_state.cr |= (0x80000000UL >> reg_d);
     } else {
@@ -1300,6 +1333,7 @@ void dppc_interpreter::ppc_crandc() {
 }
 void dppc_interpreter::ppc_creqv() {
     ppc_grab_dab(ppc_cur_instruction);
+    ppc_cr_sync();
     uint8_t ir = (ppc_state.cr >> (31 - reg_a)) ^ (ppc_state.cr >> (31 - reg_b));
     if (ir & 1) { // compliment is implemented by swapping the following if/else bodies
         ppc_state.cr &= ~(0x80000000UL >> reg_d);
@@ -1309,6 +1343,7 @@ void dppc_interpreter::ppc_creqv() {
 }
 void dppc_interpreter::ppc_crnand() {
     ppc_grab_dab(ppc_cur_instruction);
+    ppc_cr_sync();
     uint8_t ir = (ppc_state.cr >> (31 - reg_a)) & (ppc_state.cr >> (31 - reg_b));
     if (ir & 1) {
         ppc_state.cr &= ~(0x80000000UL >> reg_d);
@@ -1319,6 +1354,7 @@ void dppc_interpreter::ppc_crnand() {
 
 void dppc_interpreter::ppc_crnor() {
     ppc_grab_dab(ppc_cur_instruction);
+    ppc_cr_sync();
     uint8_t ir = (ppc_state.cr >> (31 - reg_a)) | (ppc_state.cr >> (31 - reg_b));
     if (ir & 1) {
         ppc_state.cr &= ~(0x80000000UL >> reg_d);
@@ -1329,6 +1365,7 @@ void dppc_interpreter::ppc_crnor() {
 
 void dppc_interpreter::ppc_cror() {
     ppc_grab_dab(ppc_cur_instruction);
+    ppc_cr_sync();
     uint8_t ir = (ppc_state.cr >> (31 - reg_a)) | (ppc_state.cr >> (31 - reg_b));
     if (ir & 1) {
         ppc_state.cr |= (0x80000000UL >> reg_d);
@@ -1339,6 +1376,7 @@ void dppc_interpreter::ppc_cror() {
 
 void dppc_interpreter::ppc_crorc() {
     ppc_grab_dab(ppc_cur_instruction);
+    ppc_cr_sync();
     if ((ppc_state.cr & (0x80000000UL >> reg_a)) || !(ppc_state.cr & (0x80000000UL >> reg_b))) {
         ppc_state.cr |= (0x80000000UL >> reg_d);
     } else {
@@ -1347,6 +1385,7 @@ void dppc_interpreter::ppc_crorc() {
 }
 void dppc_interpreter::ppc_crxor() {
     ppc_grab_dab(ppc_cur_instruction);
+    ppc_cr_sync();
     uint8_t ir = (ppc_state.cr >> (31 - reg_a)) ^ (ppc_state.cr >> (31 - reg_b));
     if (ir & 1) {
         ppc_state.cr |= (0x80000000UL >> reg_d);
@@ -1437,7 +1476,11 @@ void dppc_interpreter::ppc_sync() {
 }
 
 void dppc_interpreter::ppc_icbi() {
-    /* placeholder */
+    ppc_grab_regsab(ppc_cur_instruction);
+    ppc_effective_address = ppc_result_b + (reg_a ? ppc_result_a : 0);
+
+    // drop predecoded instructions for this cache block
+    mmu_invalidate_icache_block(ppc_effective_address);
 }
 
 void dppc_interpreter::ppc_dcbf() {
@@ -1471,17 +1514,27 @@ void dppc_interpreter::ppc_dcbz() {
 
     ppc_effective_address &= 0xFFFFFFE0UL; // align EA on a 32-byte boundary
 
-    // the following is not especially efficient but necessary
-    // to make BlockZero under Mac OS 8.x and later to work
-    mmu_write_vmem<uint64_t>(ppc_effective_address +  0, 0);
-    mmu_write_vmem<uint64_t>(ppc_effective_address +  8, 0);
-    mmu_write_vmem<uint64_t>(ppc_effective_address + 16, 0);
-    mmu_write_vmem<uint64_t>(ppc_effective_address + 24, 0);
+    // necessary to make BlockZero under Mac OS 8.x and later to work
+    mmu_zero_vmem(ppc_effective_address, 32);
 }
 
 
 // Integer Load and Store Functions
 
+// Get up to 4 bytes of a string in guest memory order, zero padded.
+static inline uint32_t get_string_word(const uint8_t* p, uint32_t avail) {
+    uint32_t val = 0;
+    for (uint32_t i = 0; i < 4; i++)
+        val = (val << 8) | (i < avail ? p[i] : 0);
+    return val;
+}
+
+// Put up to 4 bytes of a register into a string in guest memory order.
+static inline void put_string_word(uint8_t* p, uint32_t val, uint32_t avail) {
+    for (uint32_t i = 0; i < 4 && i < avail; i++)
+        p[i] = val >> (24 - i * 8);
+}
+
 template <class T>
 void dppc_interpreter::ppc_st() {
 #ifdef CPU_PROFILING
@@ -1521,6 +1574,8 @@ void dppc_interpreter::ppc_stu() {
         ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
         ppc_effective_address += ppc_result_a;
         mmu_write_vmem<T>(ppc_effective_address, ppc_result_d);
+        if (ppc_instr_aborted())
+            return;
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
@@ -1540,6 +1595,8 @@ void dppc_interpreter::ppc_stux() {
     if (reg_a != 0) {
         ppc_effective_address = ppc_result_a + ppc_result_b;
         mmu_write_vmem<T>(ppc_effective_address, ppc_result_d);
+        if (ppc_instr_aborted())
+            return;
         ppc_state.gpr[reg_a] = ppc_effective_address;
     } else {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::ILLEGAL_OP);
@@ -1566,13 +1623,18 @@ void dppc_interpreter::ppc_stwcx() {
 #endif
     ppc_grab_regssab(ppc_cur_instruction);
     ppc_effective_address = (reg_a == 0) ? ppc_result_b : (ppc_result_a + ppc_result_b);
-    ppc_state.cr &= 0x0FFFFFFFUL; // clear CR0
-    ppc_state.cr |= (ppc_state.spr[SPR::XER] & XER::SO) >> 3; // copy XER[SO] to CR0[SO]
-    if (ppc_state.reserve) {
+    bool stored = ppc_state.reserve;
+    if (stored) {
         mmu_write_vmem<uint32_t>(ppc_effective_address, ppc_result_d);
+        if (ppc_instr_aborted())
+            return;
         ppc_state.reserve = false;
-        ppc_state.cr |= 0x20000000UL; // set CR0[EQ]
     }
+    ppc_cr_sync();
+    ppc_state.cr &= 0x0FFFFFFFUL; // clear CR0
+    ppc_state.cr |= (ppc_state.spr[SPR::XER] & XER::SO) >> 3; // copy XER[SO] to CR0[SO]
+    if (stored)
+        ppc_state.cr |= 0x20000000UL; // set CR0[EQ]
 }
 
 void dppc_interpreter::ppc_stwbrx() {
@@ -1596,12 +1658,16 @@ void dppc_interpreter::ppc_stmw() {
     /* what should we do if EA is unaligned? */
     if (ppc_effective_address & 3) {
         ppc_alignment_exception(ppc_effective_address);
+        return;
     }
 
-    for (; reg_s <= 31; reg_s++) {
-        mmu_write_vmem<uint32_t>(ppc_effective_address, ppc_state.gpr[reg_s]);
-        ppc_effective_address += 4;
-    }
+    uint8_t buf[128];
+    uint32_t size = (32 - reg_s) * 4;
+
+    for (uint8_t* p = buf; reg_s <= 31; reg_s++, p += 4)
+        WRITE_DWORD_BE_U(p, ppc_state.gpr[reg_s]);
+
+    mmu_write_vmem_bytes(ppc_effective_address, buf, size);
 }
 
 template <class T>
@@ -1613,6 +1679,8 @@ void dppc_interpreter::ppc_lz() {
     ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
     ppc_effective_address += reg_a ? ppc_result_a : 0;
     uint32_t ppc_result_d = mmu_read_vmem<T>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
     ppc_store_iresult_reg(reg_d, ppc_result_d);
 }
 
@@ -1630,6 +1698,8 @@ void dppc_interpreter::ppc_lzu() {
     if ((reg_a != reg_d) && reg_a != 0) {
         ppc_effective_address += ppc_result_a;
         uint32_t ppc_result_d = mmu_read_vmem<T>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
         uint32_t ppc_result_a = ppc_effective_address;
         ppc_store_iresult_reg(reg_d, ppc_result_d);
         ppc_store_iresult_reg(reg_a, ppc_result_a);
@@ -1650,6 +1720,8 @@ void dppc_interpreter::ppc_lzx() {
     ppc_grab_regsdab(ppc_cur_instruction);
     ppc_effective_address = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t ppc_result_d = mmu_read_vmem<T>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
     ppc_store_iresult_reg(reg_d, ppc_result_d);
 }
 
@@ -1666,6 +1738,8 @@ void dppc_interpreter::ppc_lzux() {
     if ((reg_a != reg_d) && reg_a != 0) {
         ppc_effective_address = ppc_result_a + ppc_result_b;
         uint32_t ppc_result_d = mmu_read_vmem<T>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
         ppc_result_a          = ppc_effective_address;
         ppc_store_iresult_reg(reg_d, ppc_result_d);
         ppc_store_iresult_reg(reg_a, ppc_result_a);
@@ -1686,6 +1760,8 @@ void dppc_interpreter::ppc_lha() {
     ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
     ppc_effective_address += (reg_a ? ppc_result_a : 0);
     int16_t val = mmu_read_vmem<uint16_t>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
     ppc_store_iresult_reg(reg_d, int32_t(val));
 }
 
@@ -1698,6 +1774,8 @@ void dppc_interpreter::ppc_lhau() {
         ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
         ppc_effective_address += ppc_result_a;
         int16_t val = mmu_read_vmem<uint16_t>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
         ppc_store_iresult_reg(reg_d, int32_t(val));
         uint32_t ppc_result_a = ppc_effective_address;
         ppc_store_iresult_reg(reg_a, ppc_result_a);
@@ -1714,6 +1792,8 @@ void dppc_interpreter::ppc_lhaux() {
     if ((reg_a != reg_d) && reg_a != 0) {
         ppc_effective_address = ppc_result_a + ppc_result_b;
         int16_t val = mmu_read_vmem<uint16_t>(ppc_effective_address);
+        if (ppc_instr_aborted())
+            return;
         ppc_store_iresult_reg(reg_d, int32_t(val));
         uint32_t ppc_result_a = ppc_effective_address;
         ppc_store_iresult_reg(reg_a, ppc_result_a);
@@ -1730,6 +1810,8 @@ void dppc_interpreter::ppc_lhax() {
     ppc_grab_regsdab(ppc_cur_instruction);
     ppc_effective_address = ppc_result_b + (reg_a ? ppc_result_a : 0);
     int16_t val = mmu_read_vmem<uint16_t>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
     ppc_store_iresult_reg(reg_d, int32_t(val));
 }
 
@@ -1740,6 +1822,8 @@ void dppc_interpreter::ppc_lhbrx() {
     ppc_grab_regsdab(ppc_cur_instruction);
     ppc_effective_address = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t ppc_result_d = uint32_t(BYTESWAP_16(mmu_read_vmem<uint16_t>(ppc_effective_address)));
+    if (ppc_instr_aborted())
+        return;
     ppc_store_iresult_reg(reg_d, ppc_result_d);
 }
 
@@ -1750,6 +1834,8 @@ void dppc_interpreter::ppc_lwbrx() {
     ppc_grab_regsdab(ppc_cur_instruction);
     ppc_effective_address = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t ppc_result_d = BYTESWAP_32(mmu_read_vmem<uint32_t>(ppc_effective_address));
+    if (ppc_instr_aborted())
+        return;
     ppc_store_iresult_reg(reg_d, ppc_result_d);
 }
 
@@ -1760,8 +1846,10 @@ void dppc_interpreter::ppc_lwarx() {
     // Placeholder - Get the reservation of memory implemented!
     ppc_grab_regsdab(ppc_cur_instruction);
     ppc_effective_address = ppc_result_b + (reg_a ? ppc_result_a : 0);
-    ppc_state.reserve     = true;
     uint32_t ppc_result_d = mmu_read_vmem<uint32_t>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
+    ppc_state.reserve     = true;
     ppc_store_iresult_reg(reg_d, ppc_result_d);
 }
 
@@ -1772,12 +1860,16 @@ void dppc_interpreter::ppc_lmw() {
     ppc_grab_regsda(ppc_cur_instruction);
     ppc_effective_address = int32_t(int16_t(ppc_cur_instruction));
     ppc_effective_address += (reg_a ? ppc_result_a : 0);
-    // How many words to load in memory - using a do-while for this
-    do {
-       ppc_state.gpr[reg_d] = mmu_read_vmem<uint32_t>(ppc_effective_address);
-       ppc_effective_address += 4;
-       reg_d++;
-    } while (reg_d < 32);
+
+    uint8_t buf[128];
+    uint32_t size = (32 - reg_d) * 4;
+
+    mmu_read_vmem_bytes(ppc_effective_address, buf, size);
+    if (ppc_instr_aborted())
+        return;
+
+    for (uint8_t* p = buf; reg_d < 32; reg_d++, p += 4)
+        ppc_state.gpr[reg_d] = READ_DWORD_BE_U(p);
 }
 
 void dppc_interpreter::ppc_lswi() {
@@ -1789,30 +1881,15 @@ void dppc_interpreter::ppc_lswi() {
     uint32_t grab_inb     = (ppc_cur_instruction >> 11) & 0x1F;
     grab_inb              = grab_inb ? grab_inb : 32;
 
-    while (grab_inb >= 4) {
-        ppc_state.gpr[reg_d] = mmu_read_vmem<uint32_t>(ppc_effective_address);
-        reg_d++;
-        if (reg_d >= 32) {    // wrap around through GPR0
-            reg_d = 0;
-        }
-        ppc_effective_address += 4;
-        grab_inb -= 4;
-    }
+    uint8_t buf[32];
 
-    // handle remaining bytes
-    switch (grab_inb) {
-    case 1:
-        ppc_state.gpr[reg_d] = mmu_read_vmem<uint8_t>(ppc_effective_address) << 24;
-        break;
-    case 2:
-        ppc_state.gpr[reg_d] = mmu_read_vmem<uint16_t>(ppc_effective_address) << 16;
-        break;
-    case 3:
-        ppc_state.gpr[reg_d] = mmu_read_vmem<uint16_t>(ppc_effective_address) << 16;
-        ppc_state.gpr[reg_d] += mmu_read_vmem<uint8_t>(ppc_effective_address + 2) << 8;
-        break;
-    default:
-        break;
+    mmu_read_vmem_bytes(ppc_effective_address, buf, grab_inb);
+    if (ppc_instr_aborted())
+        return;
+
+    for (uint32_t i = 0; i < grab_inb; i += 4) {
+        ppc_state.gpr[reg_d] = get_string_word(&buf[i], grab_inb - i);
+        reg_d = (reg_d + 1) & 0x1F; // wrap around through GPR0
     }
 }
 
@@ -1834,29 +1911,19 @@ void dppc_interpreter::ppc_lswx() {
     ppc_effective_address = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t grab_inb      = ppc_state.spr[SPR::XER] & 0x7F;
 
-    for (;;) {
+    uint8_t buf[128];
+
+    mmu_read_vmem_bytes(ppc_effective_address, buf, grab_inb);
+    if (ppc_instr_aborted())
+        return;
+
+    for (uint32_t i = 0; i < grab_inb; i += 4) {
         if (is_601 && (reg_d == reg_b || (reg_a != 0 && reg_d == reg_a))) {
             // UNTESTED! MPC601 manual is inconsistant on whether reg_b is skipped or not
             reg_d = (reg_d + 1) & 0x1F; // wrap around through GPR0
         }
-        switch (grab_inb) {
-        case 0:
-            return;
-        case 1:
-            ppc_state.gpr[reg_d] = mmu_read_vmem<uint8_t>(ppc_effective_address) << 24;
-            return;
-        case 2:
-            ppc_state.gpr[reg_d] = mmu_read_vmem<uint16_t>(ppc_effective_address) << 16;
-            return;
-        case 3:
-            ppc_state.gpr[reg_d] = (mmu_read_vmem<uint16_t>(ppc_effective_address) << 16)
-                                 | (mmu_read_vmem<uint8_t>(ppc_effective_address + 2) << 8);
-            return;
-        }
-        ppc_state.gpr[reg_d] = mmu_read_vmem<uint32_t>(ppc_effective_address);
+        ppc_state.gpr[reg_d] = get_string_word(&buf[i], grab_inb - i);
         reg_d = (reg_d + 1) & 0x1F; // wrap around through GPR0
-        ppc_effective_address += 4;
-        grab_inb -= 4;
     }
 }
 
@@ -1868,31 +1935,14 @@ void dppc_interpreter::ppc_stswi() {
     ppc_effective_address = reg_a ? ppc_result_a : 0;
     uint32_t grab_inb = rot_sh ? rot_sh : 32;
 
-    while (grab_inb >= 4) {
-        mmu_write_vmem<uint32_t>(ppc_effective_address, ppc_state.gpr[reg_s]);
-        reg_s++;
-        if (reg_s >= 32) {    // wrap around through GPR0
-            reg_s = 0;
-        }
-        ppc_effective_address += 4;
-        grab_inb -= 4;
-    }
+    uint8_t buf[128];
 
-    // handle remaining bytes
-    switch (grab_inb) {
-    case 1:
-        mmu_write_vmem<uint8_t>(ppc_effective_address, ppc_state.gpr[reg_s] >> 24);
-        break;
-    case 2:
-        mmu_write_vmem<uint16_t>(ppc_effective_address, ppc_state.gpr[reg_s] >> 16);
-        break;
-    case 3:
-        mmu_write_vmem<uint16_t>(ppc_effective_address, ppc_state.gpr[reg_s] >> 16);
-        mmu_write_vmem<uint8_t>(ppc_effective_address + 2, (ppc_state.gpr[reg_s] >> 8) & 0xFF);
-        break;
-    default:
-        break;
+    for (uint32_t i = 0; i < grab_inb; i += 4) {
+        put_string_word(&buf[i], ppc_state.gpr[reg_s], grab_inb - i);
+        reg_s = (reg_s + 1) & 0x1F; // wrap around through GPR0
     }
+
+    mmu_write_vmem_bytes(ppc_effective_address, buf, grab_inb);
 }
 
 void dppc_interpreter::ppc_stswx() {
@@ -1903,31 +1953,14 @@ void dppc_interpreter::ppc_stswx() {
     ppc_effective_address = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t grab_inb     = ppc_state.spr[SPR::XER] & 127;
 
-    while (grab_inb >= 4) {
-        mmu_write_vmem<uint32_t>(ppc_effective_address, ppc_state.gpr[reg_s]);
-        reg_s++;
-        if (reg_s >= 32) {    // wrap around through GPR0
-            reg_s = 0;
-        }
-        ppc_effective_address += 4;
-        grab_inb -= 4;
-    }
+    uint8_t buf[128];
 
-    // handle remaining bytes
-    switch (grab_inb) {
-    case 1:
-        mmu_write_vmem<uint8_t>(ppc_effective_address, ppc_state.gpr[reg_s] >> 24);
-        break;
-    case 2:
-        mmu_write_vmem<uint16_t>(ppc_effective_address, ppc_state.gpr[reg_s] >> 16);
-        break;
-    case 3:
-        mmu_write_vmem<uint16_t>(ppc_effective_address, ppc_state.gpr[reg_s] >> 16);
-        mmu_write_vmem<uint8_t>(ppc_effective_address + 2, (ppc_state.gpr[reg_s] >> 8) & 0xFF);
-        break;
-    default:
-        break;
+    for (uint32_t i = 0; i < grab_inb; i += 4) {
+        put_string_word(&buf[i], ppc_state.gpr[reg_s], grab_inb - i);
+        reg_s = (reg_s + 1) & 0x1F; // wrap around through GPR0
     }
+
+    mmu_write_vmem_bytes(ppc_effective_address, buf, grab_inb);
 }
 
 void dppc_interpreter::ppc_eciwx() {
@@ -1936,6 +1969,7 @@ void dppc_interpreter::ppc_eciwx() {
     // error if EAR[E] != 1
     if (!(ppc_state.spr[282] && ear_enable)) {
         ppc_exception_handler(Except_Type::EXC_DSI, 0x0);
+        return;
     }
 
     ppc_grab_regsdab(ppc_cur_instruction);
@@ -1943,9 +1977,12 @@ void dppc_interpreter::ppc_eciwx() {
 
     if (ppc_effective_address & 0x3) {
         ppc_alignment_exception(ppc_effective_address);
+        return;
     }
 
     uint32_t ppc_result_d = mmu_read_vmem<uint32_t>(ppc_effective_address);
+    if (ppc_instr_aborted())
+        return;
 
     ppc_store_iresult_reg(reg_d, ppc_result_d);
 }
@@ -1956,6 +1993,7 @@ void dppc_interpreter::ppc_ecowx() {
     // error if EAR[E] != 1
     if (!(ppc_state.spr[282] && ear_enable)) {
         ppc_exception_handler(Except_Type::EXC_DSI, 0x0);
+        return;
     }
 
     ppc_grab_regssab(ppc_cur_instruction);
@@ -1963,6 +2001,7 @@ void dppc_interpreter::ppc_ecowx() {
 
     if (ppc_effective_address & 0x3) {
         ppc_alignment_exception(ppc_effective_address);
+        return;
     }
 
     mmu_write_vmem<uint32_t>(ppc_effective_address, ppc_result_d);
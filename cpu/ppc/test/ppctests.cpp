@@ -19,14 +19,20 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include "../ppcdecodecache.h"
 #include "../ppcdisasm.h"
 #include "../ppcemu.h"
+#include "../ppcjit.h"
+#include "../ppcmmu.h"
+#include <devices/memctrl/memctrlbase.h>
 #include <cfenv>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -80,8 +86,219 @@ void xer_update_test() {
     xer_ov_test("SUBFZEO.", 0x7C630591);
 }
 
+constexpr uint32_t JIT_TEST_ADDR = 0x1000; // where the tested block goes
+
+/** Prepare a machine with some RAM for tests running guest code. */
+static void code_test_init() {
+    MemCtrlBase* mem_ctrl = new MemCtrlBase;
+
+    mem_ctrl->add_ram_region(0, 0x100000);
+    ppc_cpu_init(mem_ctrl, PPC_VER::MPC750, true, 16705000ULL);
+
+    power_on = true;
+}
+
+/** Run opcode followed by a branch as a translated block. */
+static void run_jit_block(uint32_t opcode) {
+    uint32_t phys;
+
+    mmu_write_vmem<uint32_t>(JIT_TEST_ADDR, opcode);
+    mmu_write_vmem<uint32_t>(JIT_TEST_ADDR + 4, 0x48000008); // b .+8
+    ppc_jit_flush();
+
+    uint8_t* host_va = mmu_translate_imem(JIT_TEST_ADDR, &phys);
+
+    // blocks get compiled once they've been looked up often enough
+    JitCode code = nullptr;
+    for (int i = 0; i < 1000 && !code; i++)
+        code = ppc_jit_lookup(JIT_TEST_ADDR, phys, host_va);
+
+    if (!code) {
+        cout << "JIT didn't compile the block for opcode 0x" << hex << opcode << endl;
+        return;
+    }
+
+    jit_cycle_limit = 0; // return from the block without chaining
+    exec_flags      = 0;
+    ppc_cr_sync();
+    code();
+    exec_flags      = 0;
+}
+
+/* Fused instruction pairs. Each pair is placed at FUSED_TEST_ADDR between
+   a nop and a third instruction and checked against stepping through the
+   same code with ppc_exec_single() which never uses the decode cache.
+   The nop is there because the first run after entering the interpreter
+   is only one instruction long and would never execute a fused slot. */
+constexpr uint32_t FUSED_TEST_ADDR = 0x2000;
+constexpr uint32_t FUSED_TEST_DATA = 0x3000;
+
+typedef struct FusedTest {
+    const char* name;
+    uint32_t    first;
+    uint32_t    second;
+    uint32_t    third;
+    uint32_t    new_second; // replaces the second instruction in memory
+    uint32_t    result;     // expected r31 with second and new_second
+    uint32_t    new_result;
+    uint32_t    fault_first; // variant of the first instruction that faults, 0 if none
+    uint32_t    fault_msr;   // MSR needed for the fault
+} FusedTest;
+
+static const FusedTest fused_tests[] = {
+    // r3 = 5, r4 = 5, r5 = data, r6 = 1, r7 = data + 0x100, LR = 0xCAFEBABE
+    // DSI from the empty page table, mfspr MQ is illegal on the 750
+    {"cmpwi+bc",    0x2C030005, 0x41820008, 0x3BFF0001, 0x40820008, 0, 1, 0, 0},
+    {"cmplwi+bc",   0x28030005, 0x41820008, 0x3BFF0001, 0x40820008, 0, 1, 0, 0},
+    {"cmpw+bc",     0x7C032000, 0x41820008, 0x3BFF0001, 0x40820008, 0, 1, 0, 0},
+    {"cmplw+bc",    0x7C032040, 0x41820008, 0x3BFF0001, 0x40820008, 0, 1, 0, 0},
+    {"lis+ori",     0x3FE01234, 0x63FF5678, 0x60000000, 0x63FF9ABC, 0x12345678, 0x12349ABC, 0, 0},
+    {"lis+addi",    0x3FE01234, 0x3BFF0010, 0x60000000, 0x3BFFFFF0, 0x12340010, 0x1233FFF0, 0, 0},
+    {"lwz+addi",    0x80650000, 0x3BE30001, 0x60000000, 0x3BE30002, 0x11111112, 0x11111113,
+                    0x80650000, MSR::DR},
+    {"mflr+stw",    0x7C6802A6, 0x90650000, 0x83E50000, 0x90850000, 0xCAFEBABE, 5,
+                    0x7C6002A6, 0},
+    {"rlwinm+lwzx", 0x54C4103A, 0x7FE5202E, 0x60000000, 0x7FE7202E, 0x22222222, 0x33333333, 0, 0},
+};
+
+typedef struct CodeTestState {
+    uint32_t gpr[32];
+    uint32_t cr, xer, lr, srr0, srr1, dar, pc;
+    uint32_t data[2];
+} CodeTestState;
+
+static void fused_test_setup(uint32_t msr) {
+    for (int i = 0; i < 32; i++)
+        ppc_state.gpr[i] = 0;
+    ppc_state.gpr[3] = 5;
+    ppc_state.gpr[4] = 5;
+    ppc_state.gpr[5] = FUSED_TEST_DATA;
+    ppc_state.gpr[6] = 1;
+    ppc_state.gpr[7] = FUSED_TEST_DATA + 0x100;
+
+    ppc_cr_set(0);
+    ppc_state.spr[SPR::XER]  = 0;
+    ppc_state.spr[SPR::LR]   = 0xCAFEBABE;
+    ppc_state.spr[SPR::SRR0] = 0;
+    ppc_state.spr[SPR::SRR1] = 0;
+    ppc_state.spr[SPR::DAR]  = 0;
+    ppc_state.spr[SPR::SDR1] = 0x10000; // empty page table
+
+    ppc_state.msr = 0;
+    mmu_change_mode();
+    mmu_write_vmem<uint32_t>(FUSED_TEST_DATA,         0x11111111);
+    mmu_write_vmem<uint32_t>(FUSED_TEST_DATA + 4,     0x22222222);
+    mmu_write_vmem<uint32_t>(FUSED_TEST_DATA + 0x104, 0x33333333);
+
+    ppc_state.msr = msr;
+    mmu_change_mode();
+    ppc_state.pc = FUSED_TEST_ADDR - 4;
+}
+
+static CodeTestState fused_test_state() {
+    CodeTestState st;
+
+    ppc_cr_sync();
+    for (int i = 0; i < 32; i++)
+        st.gpr[i] = ppc_state.gpr[i];
+    st.cr   = ppc_state.cr;
+    st.xer  = ppc_state.spr[SPR::XER];
+    st.lr   = ppc_state.spr[SPR::LR];
+    st.srr0 = ppc_state.spr[SPR::SRR0];
+    st.srr1 = ppc_state.spr[SPR::SRR1];
+    st.dar  = ppc_state.spr[SPR::DAR];
+    st.pc   = ppc_state.pc;
+
+    ppc_state.msr = 0;
+    mmu_change_mode();
+    st.data[0] = mmu_read_vmem<uint32_t>(FUSED_TEST_DATA);
+    st.data[1] = mmu_read_vmem<uint32_t>(FUSED_TEST_DATA + 4);
+
+    return st;
+}
+
+/** Run the pair once fused and once instruction by instruction up to
+    any of goals or an exception and compare the resulting states. */
+static void fused_test_run(const FusedTest& t, const char* what, uint32_t msr,
+                           set<uint32_t> goals, CodeTestState& st) {
+    goals.insert({0x300, 0x700}); // DSI, program
+
+    fused_test_setup(msr);
+    for (int i = 0; i < 16 && !goals.count(ppc_state.pc); i++)
+        ppc_exec_single();
+    CodeTestState ref = fused_test_state();
+
+    fused_test_setup(msr);
+    ppc_exec_until(goals);
+    st = fused_test_state();
+
+    ntested++;
+
+    if (memcmp(&st, &ref, sizeof(st))) {
+        cout << "Fused pair " << t.name << " " << what << ": state mismatch, PC=0x" << hex
+             << st.pc << " r31=0x" << st.gpr[31] << ", expected PC=0x" << ref.pc
+             << " r31=0x" << ref.gpr[31] << endl;
+        nfailed++;
+    }
+}
+
+static void fused_test_write(uint32_t addr, uint32_t opcode) {
+    ppc_state.msr = 0;
+    mmu_change_mode();
+    mmu_write_vmem<uint32_t>(addr, opcode);
+}
+
+static bool fused_test_is_fused() {
+    DecodedInstr* slots = decode_cache_get_page(FUSED_TEST_ADDR);
+    return slots[(FUSED_TEST_ADDR & 0xFFF) >> 2].flags & DC_FLAG_FUSED;
+}
+
+static void fused_test_check(const FusedTest& t, const char* what, bool ok) {
+    if (!ok) {
+        cout << "Fused pair " << t.name << ": " << what << endl;
+        nfailed++;
+    }
+}
+
+static void fused_pairs_test() {
+    const uint32_t end = FUSED_TEST_ADDR + 12;
+    CodeTestState st;
+
+    for (const FusedTest& t : fused_tests) {
+        fused_test_write(FUSED_TEST_ADDR - 4, 0x60000000); // nop
+        fused_test_write(FUSED_TEST_ADDR,     t.first);
+        fused_test_write(FUSED_TEST_ADDR + 4, t.second);
+        fused_test_write(FUSED_TEST_ADDR + 8, t.third);
+
+        // both instructions executed by the fused handler
+        fused_test_run(t, "result", 0, {end}, st);
+        fused_test_check(t, "not fused", fused_test_is_fused());
+        fused_test_check(t, "wrong result", st.gpr[31] == t.result);
+
+        // the run ends after the first instruction
+        fused_test_run(t, "run end", 0, {FUSED_TEST_ADDR + 4, end}, st);
+        fused_test_check(t, "second instruction run past the run end",
+                         st.pc == FUSED_TEST_ADDR + 4);
+
+        // the first instruction faults, the second one must not run
+        if (t.fault_first) {
+            fused_test_write(FUSED_TEST_ADDR, t.fault_first);
+            fused_test_run(t, "fault", t.fault_msr, {end}, st);
+            fused_test_check(t, "fault variant not fused", fused_test_is_fused());
+            fused_test_check(t, "no exception or wrong exception PC",
+                             st.pc != end && st.srr0 == FUSED_TEST_ADDR);
+            fused_test_write(FUSED_TEST_ADDR, t.first);
+        }
+
+        // overwriting the second instruction has to redecode the pair
+        fused_test_write(FUSED_TEST_ADDR + 4, t.new_second);
+        fused_test_run(t, "overwritten", 0, {end}, st);
+        fused_test_check(t, "stale second instruction", st.gpr[31] == t.new_result);
+    }
+}
+
 /** testing vehicle */
-static void read_test_data() {
+static void read_test_data(bool use_jit) {
     string line, token;
     int i, lineno;
     uint32_t opcode, dest, src1, src2, check_xer, check_cr;
@@ -143,17 +360,21 @@ static void read_test_data() {
         ppc_state.gpr[4]        = src2;
 
         ppc_state.spr[SPR::XER] = 0;
-        ppc_state.cr            = 0;
-
-        ppc_cur_instruction = opcode;
+        ppc_cr_set(0);
 
-        ppc_main_opcode();
+        if (use_jit) {
+            run_jit_block(opcode);
+        } else {
+            ppc_cur_instruction = opcode;
+            ppc_main_opcode();
+        }
+        ppc_cr_sync();
 
         ntested++;
 
         if ((tokens[0].rfind("CMP") && (ppc_state.gpr[3] != dest)) ||
             (ppc_state.spr[SPR::XER] != check_xer) || (ppc_state.cr != check_cr)) {
-            cout << "Mismatch: instr=" << tokens[0] << ", src1=0x" << hex << src1 << ", src2=0x"
+            cout << (use_jit ? "JIT mismatch: instr=" : "Mismatch: instr=") << tokens[0] << ", src1=0x" << hex << src1 << ", src2=0x"
                  << hex << src2 << endl;
             cout << "expected: dest=0x" << hex << dest << ", XER=0x" << hex << check_xer
                  << ", CR=0x" << hex << check_cr << endl;
@@ -287,11 +508,12 @@ static void read_test_float_data() {
         ppc_state.fpr[5].dbl64_r = dfp_src2;
         ppc_state.fpr[6].dbl64_r = dfp_src3;
 
-        ppc_state.cr = 0;
+        ppc_cr_set(0);
 
         ppc_cur_instruction = opcode;
 
         ppc_main_opcode();
+        ppc_cr_sync();
 
         ntested++;
 
@@ -328,7 +550,7 @@ int main() {
 
     cout << endl << "Testing integer instructions:" << endl;
 
-    read_test_data();
+    read_test_data(false);
 
     cout << endl << "Float IEEE suport: " << (bool)std::numeric_limits<float>::is_iec559 << endl;
     cout << endl << "Double IEEE suport: " << (bool)std::numeric_limits<double>::is_iec559 << endl;
@@ -337,6 +559,19 @@ int main() {
 
     read_test_float_data();
 
+    code_test_init();
+
+    cout << endl << "Testing fused instruction pairs:" << endl;
+
+    fused_pairs_test();
+
+    cout << endl << "Testing integer instructions in JIT blocks:" << endl;
+
+    if (ppc_jit_init())
+        read_test_data(true);
+    else
+        cout << "JIT not supported on this host, skipped." << endl;
+
     cout << "... completed." << endl;
     cout << "--> Tested instructions: " << dec << ntested << endl;
     cout << "--> Failed: " << dec << nfailed << endl << endl;
@@ -35,6 +35,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <loguru.hpp>
 #include <map>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <stdio.h>
 #include <string>
@@ -75,6 +76,8 @@ static void show_help() {
     cout << "                  as single instructions." << endl;
     cout << "  ni           -- shortcut for next" << endl;
     cout << "  until X      -- execute until address X is reached" << endl;
+    cout << "                  several addresses may be given, execution" << endl;
+    cout << "                  stops at the first one reached" << endl;
     cout << "  go           -- exit debugger and continue emulator execution" << endl;
     cout << "  regs         -- dump content of the GRPs" << endl;
     cout << "  mregs        -- dump content of the MMU registers" << endl;
@@ -339,7 +342,13 @@ static uint32_t disasm(uint32_t count, uint32_t address) {
     ctx.simplified = true;
 
     for (int i = 0; power_on && i < count; i++) {
-        ctx.instr_code = READ_DWORD_BE_A(mmu_translate_imem(ctx.instr_addr));
+        // don't raise exceptions in the guest for unmapped addresses
+        try {
+            ctx.instr_code = (uint32_t)mem_read_dbg(ctx.instr_addr, 4);
+        } catch (invalid_argument& exc) {
+            cout << "Unable to fetch instruction at 0x" << hex << ctx.instr_addr << endl;
+            break;
+        }
         cout << setfill('0') << setw(8) << right << uppercase << hex << ctx.instr_addr;
         cout << ": " << setfill('0') << setw(8) << right << uppercase << hex << ctx.instr_code;
         cout << "    " << disassemble_single(&ctx) << setfill(' ') << left << endl;
@@ -635,6 +644,12 @@ void enter_debugger() {
 #ifdef ENABLE_68K_DEBUGGER
                     exec_until_68k(addr);
 #endif
+                } else if (ss >> addr_str) {
+                    set<uint32_t> goal_addrs = {addr};
+                    do {
+                        goal_addrs.insert(str2addr(addr_str));
+                    } while (ss >> addr_str);
+                    ppc_exec_until(goal_addrs);
                 } else {
                     ppc_exec_until(addr);
                 }
@@ -62,7 +62,6 @@ DMACmd* DMAChannel::fetch_cmd(uint32_t cmd_addr, DMACmd* p_cmd, bool *is_writabl
 
 uint8_t DMAChannel::interpret_cmd() {
     DMACmd cmd_struct;
-    MapDmaResult res;
 
     if (this->cmd_in_progress) {
         // return current command if there is data to transfer
@@ -90,8 +89,11 @@ uint8_t DMAChannel::interpret_cmd() {
         }
         this->queue_len  = cmd_struct.req_count;
         if (this->queue_len) {
-            res = mmu_map_dma_mem(cmd_struct.address, cmd_struct.req_count, false);
-            this->queue_data = res.host_va;
+            // the buffer may span several memory regions
+            mmu_map_dma_sg(cmd_struct.address, cmd_struct.req_count, false, this->queue_segs);
+            this->seg_idx    = 0;
+            this->queue_data = this->queue_segs[0].host_va;
+            this->seg_len    = this->queue_segs[0].size;
             this->res_count  = 0;
             this->cmd_in_progress = true;
             switch (this->cur_cmd) {
@@ -284,7 +286,7 @@ void DMAChannel::update_irq() {
                 if (int_ctrl) {
                     TimerManager::get_instance()->add_immediate_timer([this] {
                         this->int_ctrl->ack_dma_int(this->irq_id, 1);
-                    });
+                    }, "DBDMA IRQ");
                 } else
                     LOG_F(ERROR, "%s Interrupt ignored", this->get_name().c_str());
             }
@@ -418,23 +420,14 @@ DmaPullResult DMAChannel::pull_data(uint32_t req_len, uint32_t *avail_len, uint8
         this->interpret_cmd();
     }
 
-    // dequeue data if any
+    // dequeue data if any, up to the end of the current segment
     if (this->queue_len) {
-        if (this->queue_len >= req_len) {
-            LOG_F(9, "%s: Return req_len = %d data", this->get_name().c_str(), req_len);
-            *p_data    = this->queue_data;
-            *avail_len = req_len;
-            this->queue_len -= req_len;
-            this->res_count += req_len;
-            this->queue_data += req_len;
-        } else { // return less data than req_len
-            LOG_F(9, "%s: Return queue_len = %d data", this->get_name().c_str(),
-                this->queue_len);
-            *p_data         = this->queue_data;
-            *avail_len      = this->queue_len;
-            this->res_count += this->queue_len;
-            this->queue_len = 0;
-        }
+        uint32_t len = std::min(req_len, this->seg_len);
+        LOG_F(9, "%s: Return %d of %d bytes requested", this->get_name().c_str(),
+            len, req_len);
+        *p_data    = this->queue_data;
+        *avail_len = len;
+        this->advance_queue(len);
         return DmaPullResult::MoreData; // tell the caller there is more data
     }
 
@@ -453,12 +446,12 @@ int DMAChannel::push_data(const char* src_ptr, int len) {
         this->interpret_cmd();
     }
 
-    if (this->queue_len) {
-        len = std::min((int)this->queue_len, len);
-        std::memcpy(this->queue_data, src_ptr, len);
-        this->queue_data += len;
-        this->res_count  += len;
-        this->queue_len  -= len;
+    while (this->queue_len && len > 0) {
+        uint32_t seg_part = std::min(this->seg_len, (uint32_t)len);
+        std::memcpy(this->queue_data, src_ptr, seg_part);
+        this->advance_queue(seg_part);
+        src_ptr += seg_part;
+        len     -= seg_part;
     }
 
     // proceed with the DBDMA program if the buffer became exhausted
@@ -469,6 +462,19 @@ int DMAChannel::push_data(const char* src_ptr, int len) {
     return 0;
 }
 
+void DMAChannel::advance_queue(uint32_t len) {
+    this->queue_data += len;
+    this->seg_len    -= len;
+    this->queue_len  -= len;
+    this->res_count  += len;
+
+    if (!this->seg_len && this->queue_len) {
+        const DmaSegment& seg = this->queue_segs[++this->seg_idx];
+        this->queue_data = seg.host_va;
+        this->seg_len    = seg.size;
+    }
+}
+
 void DMAChannel::end_pull_data() {
     if (this->ch_stat & CH_STAT_DEAD || !(this->ch_stat & CH_STAT_ACTIVE)) {
         // dead or idle channel? -> no more data
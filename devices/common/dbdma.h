@@ -29,10 +29,12 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef DB_DMA_H
 #define DB_DMA_H
 
+#include <cpu/ppc/ppcmmu.h>
 #include <devices/common/dmacore.h>
 
 #include <cinttypes>
 #include <functional>
+#include <vector>
 
 class InterruptCtrl;
 
@@ -134,6 +136,7 @@ protected:
     void finish_cmd();
     void xfer_quad(const DMACmd *cmd_desc, DMACmd *cmd_host);
     void update_irq();
+    void advance_queue(uint32_t len);
 
     void start(void);
     void resume(void);
@@ -149,13 +152,17 @@ private:
 
     uint16_t ch_stat        = 0;
     uint32_t cmd_ptr        = 0;
-    uint32_t queue_len      = 0;
-    uint8_t* queue_data     = 0;
+    uint32_t queue_len      = 0; // bytes left in the current command
+    uint8_t* queue_data     = 0; // next byte of the current segment
+    uint32_t seg_len        = 0; // bytes left in the current segment
+    size_t   seg_idx        = 0;
     uint32_t res_count      = 0;
     uint32_t int_select     = 0;
     uint32_t branch_select  = 0;
     uint32_t wait_select    = 0;
 
+    std::vector<DmaSegment> queue_segs; // guest memory of the current command
+
     bool     cmd_in_progress = false;
     uint8_t  cur_cmd;
 
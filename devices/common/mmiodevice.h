@@ -27,6 +27,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <cinttypes>
 #include <string>
 
+class MMIOHandlerTable;
+
 /** Abstract class representing a simple, memory-mapped I/O device */
 class MMIODevice : public HWComponent {
 public:
@@ -34,6 +36,9 @@ public:
     virtual uint32_t read(uint32_t rgn_start, uint32_t offset, int size)              = 0;
     virtual void write(uint32_t rgn_start, uint32_t offset, uint32_t value, int size) = 0;
     virtual ~MMIODevice()                                                             = default;
+
+    // handlers for hot registers of the region at rgn_start, see mmiohandlers.h
+    virtual MMIOHandlerTable* get_mmio_handlers(uint32_t rgn_start) { return nullptr; };
 };
 
 #define SIZE_ARG(size) (size == 4 ? 'l' : size == 2 ? 'w' : \
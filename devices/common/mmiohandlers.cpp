@@ -0,0 +1,120 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Per-register MMIO handler tables. */
+
+#include <devices/common/mmiohandlers.h>
+#include <loguru.hpp>
+#include <utils/profiler.h>
+
+#include <algorithm>
+
+static std::vector<MMIOHandlerTable*> handler_tables;
+
+class MMIOProfile : public BaseProfile {
+public:
+    MMIOProfile() : BaseProfile("MMIO") {};
+
+    void populate_variables(std::vector<ProfileVar>& vars) {
+        vars.clear();
+
+        for (auto tbl : handler_tables) {
+            uint64_t total = tbl->other_reads + tbl->other_writes;
+            for (auto& reg : tbl->regs)
+                total += reg.reads + reg.writes;
+
+            // percentages are relative to all accesses to the device
+            total = std::max(total, (uint64_t)1);
+
+            for (auto& reg : tbl->regs) {
+                vars.push_back({.name = tbl->name + ":" + reg.name + " reads",
+                                .format = ProfileVarFmt::COUNT,
+                                .value = reg.reads,
+                                .count_total = total});
+                vars.push_back({.name = tbl->name + ":" + reg.name + " writes",
+                                .format = ProfileVarFmt::COUNT,
+                                .value = reg.writes,
+                                .count_total = total});
+            }
+
+            vars.push_back({.name = tbl->name + ": other reads",
+                            .format = ProfileVarFmt::COUNT,
+                            .value = tbl->other_reads,
+                            .count_total = total});
+            vars.push_back({.name = tbl->name + ": other writes",
+                            .format = ProfileVarFmt::COUNT,
+                            .value = tbl->other_writes,
+                            .count_total = total});
+        }
+    };
+
+    void reset() {
+        for (auto tbl : handler_tables) {
+            for (auto& reg : tbl->regs)
+                reg.reads = reg.writes = 0;
+            tbl->other_reads = tbl->other_writes = 0;
+        }
+    };
+};
+
+MMIOHandlerTable::MMIOHandlerTable(const std::string name) {
+    this->name = name;
+
+    if (handler_tables.empty() && gProfilerObj)
+        gProfilerObj->register_profile("MMIO",
+            std::unique_ptr<BaseProfile>(new MMIOProfile()));
+
+    handler_tables.push_back(this);
+}
+
+MMIOHandlerTable::~MMIOHandlerTable() {
+    handler_tables.erase(std::remove(handler_tables.begin(), handler_tables.end(), this),
+                         handler_tables.end());
+}
+
+void MMIOHandlerTable::add_reg(const std::string name, uint32_t offset, uint32_t size,
+                               uint8_t acc_sizes, MMIOReadHandler read_fn,
+                               MMIOWriteHandler write_fn)
+{
+    if (!size)
+        return;
+
+    this->regs.push_back({name, offset, size, acc_sizes, read_fn, write_fn, 0, 0});
+
+    uint16_t reg_idx = (uint16_t)this->regs.size();
+    uint32_t end     = offset + size - 1;
+
+    if ((end >> 12) >= this->pages.size())
+        this->pages.resize((end >> 12) + 1);
+
+    for (uint64_t addr = offset; addr <= end; addr++) {
+        auto& page = this->pages[addr >> 12];
+        if (!page)
+            page.reset(new uint16_t[1 << 12]());
+        if (page[addr & 0xFFF]) {
+            LOG_F(ERROR, "%s: MMIO handler %s overlaps %s at offset 0x%X",
+                  this->name.c_str(), name.c_str(),
+                  this->regs[page[addr & 0xFFF] - 1].name.c_str(), (uint32_t)addr);
+            continue;
+        }
+        page[addr & 0xFFF] = reg_idx;
+    }
+}
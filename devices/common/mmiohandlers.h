@@ -0,0 +1,130 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Per-register MMIO handler tables.
+
+    A device may attach a handler table to its MMIO region by overriding
+    MMIODevice::get_mmio_handlers(). Accesses to registers listed in the
+    table are dispatched by the MMU straight to the registered handler,
+    skipping the virtual MMIODevice::read()/write() call and the offset
+    decoding done there. Everything else still goes through read()/write().
+
+    Each table counts accesses per register as well as those falling
+    through to read()/write(). The counters are reported by the "MMIO"
+    profile.
+ */
+
+#ifndef MMIO_HANDLERS_H
+#define MMIO_HANDLERS_H
+
+#include <devices/common/mmiodevice.h>
+#include <devices/memctrl/memctrlbase.h>
+
+#include <cinttypes>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** Access sizes a register handler accepts, may be combined. */
+enum : uint8_t {
+    MMIO_ACC_BYTE = 1,
+    MMIO_ACC_HALF = 2,
+    MMIO_ACC_WORD = 4,
+    MMIO_ACC_ANY  = MMIO_ACC_BYTE | MMIO_ACC_HALF | MMIO_ACC_WORD,
+};
+
+/** Handlers receive the offset relative to the start of the region
+    just like MMIODevice::read()/write() do. */
+typedef std::function<uint32_t(uint32_t offset, int size)>             MMIOReadHandler;
+typedef std::function<void(uint32_t offset, uint32_t value, int size)> MMIOWriteHandler;
+
+typedef struct MMIOReg {
+    std::string         name;
+    uint32_t            offset;     // offset of the first byte handled
+    uint32_t            size;       // number of bytes handled
+    uint8_t             acc_sizes;  // access sizes handled, see above
+    MMIOReadHandler     read_fn;    // reads fall through if empty
+    MMIOWriteHandler    write_fn;   // writes fall through if empty
+    uint64_t            reads;
+    uint64_t            writes;
+} MMIOReg;
+
+class MMIOHandlerTable {
+public:
+    MMIOHandlerTable(const std::string name);
+    ~MMIOHandlerTable();
+
+    /** Registers handlers for size bytes of register space at offset. */
+    void add_reg(const std::string name, uint32_t offset, uint32_t size, uint8_t acc_sizes,
+                 MMIOReadHandler read_fn, MMIOWriteHandler write_fn);
+
+    MMIOReg* find_reg(uint32_t offset, int size) {
+        uint32_t page_num = offset >> 12;
+        if (page_num >= this->pages.size() || !this->pages[page_num])
+            return nullptr;
+
+        uint16_t reg_idx = this->pages[page_num][offset & 0xFFF];
+        if (!reg_idx || !(this->regs[reg_idx - 1].acc_sizes & size))
+            return nullptr;
+
+        return &this->regs[reg_idx - 1];
+    }
+
+    std::string             name;
+    std::vector<MMIOReg>    regs;
+    uint64_t                other_reads  = 0; // accesses left to read()/write()
+    uint64_t                other_writes = 0;
+
+private:
+    // index into regs + 1 for every byte of the register space, 0 if unhandled
+    std::vector<std::unique_ptr<uint16_t[]>> pages;
+};
+
+/** Dispatches MMIO accesses to the registered handler or the device. */
+inline uint32_t mmio_read(const AddressMapEntry* rgn, uint32_t offset, int size) {
+    if (rgn->handlers) {
+        MMIOReg* reg = rgn->handlers->find_reg(offset, size);
+        if (reg && reg->read_fn) {
+            reg->reads++;
+            return reg->read_fn(offset, size);
+        }
+        rgn->handlers->other_reads++;
+    }
+
+    return rgn->devobj->read(rgn->start, offset, size);
+}
+
+inline void mmio_write(const AddressMapEntry* rgn, uint32_t offset, uint32_t value, int size) {
+    if (rgn->handlers) {
+        MMIOReg* reg = rgn->handlers->find_reg(offset, size);
+        if (reg && reg->write_fn) {
+            reg->writes++;
+            reg->write_fn(offset, value, size);
+            return;
+        }
+        rgn->handlers->other_writes++;
+    }
+
+    rgn->devobj->write(rgn->start, offset, value, size);
+}
+
+#endif // MMIO_HANDLERS_H
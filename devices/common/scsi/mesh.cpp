@@ -187,7 +187,7 @@ void MeshController::seq_defer_state(uint64_t delay_ns) {
             // re-enter the sequencer with the state specified in next_state
             this->cur_state = this->next_state;
             this->sequencer();
-    });
+    }, "MESH seq");
 }
 
 void MeshController::sequencer()
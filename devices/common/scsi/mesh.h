@@ -172,7 +172,7 @@ private:
     uint16_t    bus_stat;
 
     // Sequencer state
-    uint32_t    seq_timer_id;
+    uint64_t    seq_timer_id;
     uint32_t    cur_state;
     uint32_t    next_state;
 
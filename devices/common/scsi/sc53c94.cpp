@@ -289,7 +289,7 @@ void Sc53C94::exec_command()
             [this]() {
                 my_timer_id = 0;
                 this->bus_obj->release_ctrl_line(this->my_bus_id, SCSI_CTRL_RST);
-        });
+        }, "SC53C94 seq");
         if (!(config1 & 0x40)) {
             LOG_F(INFO, "%s: reset interrupt issued", this->name.c_str());
             this->int_status = INTSTAT_SRST;
@@ -423,7 +423,7 @@ void Sc53C94::seq_defer_state(uint64_t delay_ns)
             this->seq_timer_id = 0;
             this->cur_state = this->next_state;
             this->sequencer();
-    });
+    }, "SC53C94 seq");
 }
 
 void Sc53C94::sequencer()
@@ -686,7 +686,7 @@ void Sc53C94::real_dma_xfer_out()
                 // re-enter the sequencer with the state specified in next_state
                 this->dma_timer_id = 0;
                 this->real_dma_xfer_out();
-        });
+        }, "SC53C94 DMA");
     }
 }
 
@@ -718,7 +718,7 @@ void Sc53C94::real_dma_xfer_in()
                 // re-enter the sequencer with the state specified in next_state
                 this->dma_timer_id = 0;
                 this->real_dma_xfer_in();
-        });
+        }, "SC53C94 DMA");
     }
 }
 
@@ -735,7 +735,7 @@ void Sc53C94::dma_wait() {
             [this]() {
                 this->dma_timer_id = 0;
                 this->dma_wait();
-        });
+        }, "SC53C94 DMA");
     }
 }
 
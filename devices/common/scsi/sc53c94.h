@@ -253,7 +253,7 @@ protected:
 private:
     uint8_t     chip_id = 0;
     uint8_t     my_bus_id = 0;
-    uint32_t    my_timer_id = 0;
+    uint64_t    my_timer_id = 0;
 
     uint8_t     cmd_fifo[2];
     uint8_t     data_fifo[16];
@@ -275,7 +275,7 @@ private:
     uint8_t     config3 = 0;
 
     // sequencer state
-    uint32_t    seq_timer_id = 0;
+    uint64_t    seq_timer_id = 0;
     uint32_t    cur_state = 0;
     uint32_t    next_state = 0;
     SeqDesc*    cmd_steps = nullptr;
@@ -292,7 +292,7 @@ private:
     // DMA related stuff
     DmaBidirChannel*    dma_ch = nullptr;
     DrqCb               drq_cb = nullptr;
-    uint32_t            dma_timer_id = 0;
+    uint64_t            dma_timer_id = 0;
 };
 
 #endif // SC_53C94_H
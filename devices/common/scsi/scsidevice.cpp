@@ -55,7 +55,7 @@ void ScsiDevice::notify(ScsiMsg msg_type, int param)
                             this->last_selection_has_atention = false;
                             this->switch_phase(ScsiPhase::COMMAND);
                         }
-                });
+                }, "SCSI device");
             }
             break;
         }
@@ -495,7 +495,7 @@ void ScsiHardDisk::format() {
 
     TimerManager::get_instance()->add_oneshot_timer(NS_PER_SEC, [this]() {
         this->switch_phase(ScsiPhase::STATUS);
-    });
+    }, "SCSI HD");
 }
 
 void ScsiHardDisk::read(uint32_t lba, uint16_t transfer_len, uint8_t cmd_len) {
@@ -242,7 +242,7 @@ void ViaCuda::write(int reg, uint8_t value) {
             [this]() {
                 this->t1_timer_id = 0;
                 this->assert_t1_int();
-            }
+            }, "VIA T1"
         );
         break;
     case VIA_T2CH:
@@ -268,7 +268,7 @@ void ViaCuda::write(int reg, uint8_t value) {
             [this]() {
                 this->t2_timer_id = 0;
                 this->assert_t2_int();
-            }
+            }, "VIA T2"
         );
         break;
     case VIA_SR:
@@ -360,7 +360,7 @@ void ViaCuda::schedule_sr_int(uint64_t timeout_ns) {
         [this]() {
             this->sr_timer_id = 0;
             this->assert_sr_int();
-        }
+        }, "VIA SR"
     );
 }
 
@@ -390,7 +390,7 @@ void ViaCuda::write(uint8_t new_state) {
                         this->via_regs[VIA_B] &= ~CUDA_TREQ; // assert TREQ
                         this->treq = 0;
                         this->treq_timer_id = 0;
-                });
+                }, "Cuda TREQ");
             }
 
             this->in_count = 0;
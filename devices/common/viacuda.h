@@ -181,16 +181,16 @@ private:
     float via_clk_dur; // one VIA clock duration = 1,27655 us
 
     // VIA internal state
-    uint32_t sr_timer_id = 0;
+    uint64_t sr_timer_id = 0;
 
     // timer 1 state
     uint16_t t1_counter;
-    uint32_t t1_timer_id = 0;
+    uint64_t t1_timer_id = 0;
     uint64_t t1_start_time = 0;
 
     // timer 2 state
     uint16_t t2_counter;
-    uint32_t t2_timer_id = 0;
+    uint64_t t2_timer_id = 0;
     uint64_t t2_start_time = 0;
 
     // VIA interrupt related stuff
@@ -204,7 +204,7 @@ private:
     uint8_t  old_tip;
     uint8_t  old_byteack;
     uint8_t  treq;
-    uint32_t treq_timer_id = 0;
+    uint64_t treq_timer_id = 0;
     uint8_t  in_buf[CUDA_IN_BUF_SIZE];
     int32_t  in_count;
     uint8_t  out_buf[16];
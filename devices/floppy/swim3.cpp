@@ -253,7 +253,7 @@ void Swim3Ctrl::start_stepping()
             USECS_TO_NSECS(80),
             [this]() {
                 this->do_step();
-            }
+            }, "SWIM3 step"
         );
     }
 
@@ -298,7 +298,7 @@ void Swim3Ctrl::start_disk_access()
         [this]() {
             this->cur_state = SWIM3_ADDR_MARK_SEARCH;
             this->disk_access();
-        }
+        }, "SWIM3 disk access"
     );
 }
 
@@ -349,7 +349,7 @@ void Swim3Ctrl::disk_access()
         delay,
         [this]() {
             this->disk_access();
-        }
+        }, "SWIM3 disk access"
     );
 }
 
@@ -381,7 +381,7 @@ void Swim3Ctrl::init_timer(const uint8_t start_val)
             this->timer_val = 0;
             this->int_flags |= INT_TIMER_DONE;
             update_irq();
-        }
+        }, "SWIM3 timer"
     );
 }
 
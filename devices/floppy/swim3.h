@@ -133,9 +133,9 @@ private:
     uint8_t rd_line;
     int     cur_state;
 
-    int     one_us_timer_id = 0;
-    int     step_timer_id   = 0;
-    int     access_timer_id = 0;
+    uint64_t    one_us_timer_id = 0;
+    uint64_t    step_timer_id   = 0;
+    uint64_t    access_timer_id = 0;
 
     uint64_t    one_us_timer_start = 0;
 
@@ -74,6 +74,22 @@ AMIC::AMIC() : MMIODevice()
     // connect Cuda
     this->viacuda = dynamic_cast<ViaCuda*>(gMachineObj->get_comp_by_name("ViaCuda"));
 
+    // let the MMU call the handlers of the most frequently polled registers directly
+    this->mmio_handlers.add_reg("VIA1", 0, 0x2000, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) {
+            return this->viacuda->read(offset >> 9);
+        },
+        [this](uint32_t offset, uint32_t value, int size) {
+            this->viacuda->write(offset >> 9, value);
+        });
+    // byte-wide status registers, writes go to write()
+    this->mmio_handlers.add_reg("VIA2_IFR", AMICReg::VIA2_IFR, 1, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) { return this->via2_ifr; }, nullptr);
+    this->mmio_handlers.add_reg("Int_Ctrl", AMICReg::Int_Ctrl, 1, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) {
+            return (this->int_ctrl & 0xC0) | (this->dev_irq_lines & 0x3F);
+        }, nullptr);
+
     // initialize sound HW
     this->snd_out_dma = std::unique_ptr<AmicSndOutDma> (new AmicSndOutDma());
     this->snd_out_dma->init_interrupts(this, 2 << 8);
@@ -114,7 +130,7 @@ int AMIC::device_postinit()
         static_cast<uint64_t>((1.0f/60.15) * NS_PER_SEC + 0.5f),
         [this]() {
             this->viacuda->assert_ctrl_line(ViaLine::CA1);
-        });
+        }, "AMIC pseudo VBL");
 
     // set EMMO pin status (active low)
     this->emmo_pin = GET_BIN_PROP("emmo") ^ 1;
@@ -575,7 +591,7 @@ void AmicSndOutDma::update_irq() {
         this->irq_level = new_level;
         TimerManager::get_instance()->add_immediate_timer([this] {
             this->int_ctrl->ack_dma_int(this->irq_id, this->irq_level);
-        });
+        }, "AMIC DMA IRQ");
     }
 }
 
@@ -623,15 +639,36 @@ DmaPullResult AmicSndOutDma::pull_data(uint32_t req_len, uint32_t *avail_len,
 
     uint32_t len = std::min((uint32_t)rem_len, req_len);
 
-    MapDmaResult res = mmu_map_dma_mem(
-        (this->snd_buf_num ? this->out_buf1 : this->out_buf0) + this->cur_buf_pos,
-        len, false);
-    *p_data = res.host_va;
+    // return what's contiguous, the rest will be pulled by the next call
+    mmu_map_dma_sg((this->snd_buf_num ? this->out_buf1 : this->out_buf0) + this->cur_buf_pos,
+                   len, false, this->segs);
+    *p_data = this->segs[0].host_va;
+    len     = this->segs[0].size;
     this->cur_buf_pos += len;
     *avail_len = len;
     return DmaPullResult::MoreData;
 }
 
+// Copy len bytes to guest memory at addr, which may span several regions.
+// Writes to read-only memory abort unless ignore_ro is set, in which case
+// they are dropped like the ROM does on real hardware.
+static void dma_copy_to_guest(uint32_t addr, const char* src_ptr, int len,
+                              std::vector<DmaSegment>& segs, bool ignore_ro = false)
+{
+    mmu_map_dma_sg(addr, len, false, segs);
+
+    for (auto& seg : segs) {
+        if (seg.is_writable) {
+            std::memcpy(seg.host_va, src_ptr, seg.size);
+        } else if (ignore_ro) {
+            LOG_F(WARNING, "AMIC: DMA write to read-only memory ignored");
+        } else {
+            ABORT_F("AMIC: attempting DMA write to read-only memory");
+        }
+        src_ptr += seg.size;
+    }
+}
+
 // ============================ Floppy DMA stuff ===============================
 void AmicFloppyDma::reset(const uint32_t addr_ptr)
 {
@@ -661,12 +698,7 @@ int AmicFloppyDma::push_data(const char* src_ptr, int len)
 {
     len = std::min((int)this->byte_count, len);
 
-    MapDmaResult res = mmu_map_dma_mem(this->addr_ptr, len, false);
-    uint8_t *p_data = res.host_va;
-    if (!res.is_writable) {
-        ABORT_F("AMIC: attempting DMA write to read-only memory");
-    }
-    std::memcpy(p_data, src_ptr, len);
+    dma_copy_to_guest(this->addr_ptr, src_ptr, len, this->segs);
 
     this->addr_ptr += len;
     this->byte_count -= len;
@@ -710,9 +742,8 @@ void AmicScsiDma::write_ctrl(uint8_t value)
 
 int AmicScsiDma::push_data(const char* src_ptr, int len)
 {
-    MapDmaResult res = mmu_map_dma_mem(this->addr_ptr, len, false);
-    uint8_t *p_data = res.host_va;
-    std::memcpy(p_data, src_ptr, len);
+    // SCSI transfers never aborted the emulator, keep it that way
+    dma_copy_to_guest(this->addr_ptr, src_ptr, len, this->segs, true);
 
     this->addr_ptr += len;
 
@@ -722,10 +753,11 @@ int AmicScsiDma::push_data(const char* src_ptr, int len)
 DmaPullResult AmicScsiDma::pull_data(uint32_t req_len, uint32_t *avail_len,
                                      uint8_t **p_data)
 {
-    MapDmaResult res = mmu_map_dma_mem(this->addr_ptr, req_len, false);
-    *p_data = res.host_va;
-    this->addr_ptr += req_len;
-    *avail_len = req_len;
+    // return what's contiguous, the rest will be pulled by the next call
+    mmu_map_dma_sg(this->addr_ptr, req_len, false, this->segs);
+    *p_data = this->segs[0].host_va;
+    *avail_len = this->segs[0].size;
+    this->addr_ptr += *avail_len;
     return DmaPullResult::MoreData;
 }
 
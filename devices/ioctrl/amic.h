@@ -24,15 +24,18 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef AMIC_H
 #define AMIC_H
 
+#include <cpu/ppc/ppcmmu.h>
 #include <devices/common/dmacore.h>
 #include <devices/common/hwinterrupt.h>
 #include <devices/common/mmiodevice.h>
+#include <devices/common/mmiohandlers.h>
 #include <devices/sound/awacs.h>
 #include <devices/video/displayid.h>
 #include <devices/video/pdmonboard.h>
 
 #include <cinttypes>
 #include <memory>
+#include <vector>
 
 class EsccController;
 class MaceController;
@@ -119,6 +122,8 @@ private:
     uint32_t        snd_buf_num;
     uint32_t        cur_buf_pos;
 
+    std::vector<DmaSegment> segs;
+
     InterruptCtrl   *int_ctrl = nullptr;
     uint32_t        irq_id = 0;
     uint8_t         irq_level = 0;
@@ -143,6 +148,8 @@ private:
     uint32_t        addr_ptr;
     uint16_t        byte_count;
     uint8_t         stat;
+
+    std::vector<DmaSegment> segs;
 };
 
 /** AMIC specific Serial Transmit DMA channel. */
@@ -182,6 +189,8 @@ private:
     uint32_t        addr_ptr;
     uint16_t        byte_count;
     uint8_t         stat;
+
+    std::vector<DmaSegment> segs;
 };
 
 // macro for byte wise updating of AMIC DMA address registers
@@ -293,6 +302,7 @@ public:
     /* MMIODevice methods */
     uint32_t read(uint32_t rgn_start, uint32_t offset, int size);
     void write(uint32_t rgn_start, uint32_t offset, uint32_t value, int size);
+    MMIOHandlerTable* get_mmio_handlers(uint32_t rgn_start) { return &this->mmio_handlers; };
 
     // InterruptCtrl methods
     uint32_t register_dev_int(IntSrc src_id);
@@ -342,7 +352,7 @@ private:
     uint8_t     via2_slot_ifr   = 0x7F; // reverse logic
     uint8_t     via2_slot_irq   =    0; // normal logic
 
-    uint32_t    pseudo_vbl_tid  =    0; // ID for the pseudo-VBL timer
+    uint64_t    pseudo_vbl_tid  =    0; // ID for the pseudo-VBL timer
 
     // AMIC subdevice instances
     Sc53C94*            scsi;
@@ -362,6 +372,8 @@ private:
     std::unique_ptr<DisplayID>          disp_id;
     std::unique_ptr<PdmOnboardVideo>    def_vid;
     uint8_t                             mon_id;
+
+    MMIOHandlerTable                    mmio_handlers{"AMIC"};
 };
 
 #endif // AMIC_H
@@ -74,6 +74,22 @@ GrandCentral::GrandCentral() : PCIDevice("mac-io/grandcentral"), InterruptCtrl()
     // connect Cuda
     this->viacuda = dynamic_cast<ViaCuda*>(gMachineObj->get_comp_by_name("ViaCuda"));
 
+    // let the MMU call the handlers of the most frequently polled registers directly
+    this->mmio_handlers.add_reg("VIA-CUDA", 0x16000, 0x2000, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) {
+            return this->viacuda->read((offset >> 9) & 0xF);
+        },
+        [this](uint32_t offset, uint32_t value, int size) {
+            this->viacuda->write((offset >> 9) & 0xF, value);
+        });
+    // interrupt registers are decoded by their exact offset, writes go to write()
+    this->mmio_handlers.add_reg("INT_EVENTS1", MIO_INT_EVENTS1, 1, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) { return BYTESWAP_32(this->int_events); }, nullptr);
+    this->mmio_handlers.add_reg("INT_MASK1", MIO_INT_MASK1, 1, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) { return BYTESWAP_32(this->int_mask); }, nullptr);
+    this->mmio_handlers.add_reg("INT_LEVELS1", MIO_INT_LEVELS1, 1, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) { return BYTESWAP_32(this->int_levels); }, nullptr);
+
     // initialize sound chip and its DMA output channel, then wire them together
     this->awacs       = std::unique_ptr<AwacsScreamer> (new AwacsScreamer());
     this->snd_out_dma = std::unique_ptr<DMAChannel> (new DMAChannel("snd_out"));
@@ -66,6 +66,22 @@ HeathrowIC::HeathrowIC() : PCIDevice("mac-io/heathrow"), InterruptCtrl()
     // connect Cuda
     this->viacuda = dynamic_cast<ViaCuda*>(gMachineObj->get_comp_by_name("ViaCuda"));
 
+    // let the MMU call the handlers of the most frequently polled registers directly
+    this->mmio_handlers.add_reg("MIO", 0, 0x1000, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) {
+            return this->mio_ctrl_read(offset, size);
+        },
+        [this](uint32_t offset, uint32_t value, int size) {
+            this->mio_ctrl_write(offset, value, size);
+        });
+    this->mmio_handlers.add_reg("VIA-CUDA", 0x16000, 0x2000, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) {
+            return this->viacuda->read((offset - 0x16000) >> 9);
+        },
+        [this](uint32_t offset, uint32_t value, int size) {
+            this->viacuda->write((offset - 0x16000) >> 9, value);
+        });
+
     // find appropriate sound chip, create a DMA output channel for sound,
     // then wire everything together
     this->snd_codec   = dynamic_cast<MacioSndCodec*>(gMachineObj->get_comp_by_type(HWCompType::SND_CODEC));
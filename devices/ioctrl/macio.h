@@ -54,6 +54,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <devices/common/ata/idechannel.h>
 #include <devices/common/dbdma.h>
 #include <devices/common/mmiodevice.h>
+#include <devices/common/mmiohandlers.h>
 #include <devices/common/nvram.h>
 #include <devices/common/pci/pcidevice.h>
 #include <devices/common/pci/pcihost.h>
@@ -142,6 +143,7 @@ public:
     // MMIO device methods
     uint32_t read(uint32_t rgn_start, uint32_t offset, int size);
     void write(uint32_t rgn_start, uint32_t offset, uint32_t value, int size);
+    MMIOHandlerTable* get_mmio_handlers(uint32_t rgn_start) { return &this->mmio_handlers; };
 
     // InterruptCtrl methods
     uint32_t register_dev_int(IntSrc src_id);
@@ -194,6 +196,8 @@ private:
 
     uint16_t unsupported_dma_channel_read = 0;
     uint16_t unsupported_dma_channel_write = 0;
+
+    MMIOHandlerTable    mmio_handlers{"GrandCentral"};
 };
 
 class OHare : public PCIDevice, public InterruptCtrl {
@@ -208,6 +212,7 @@ public:
     // MMIO device methods
     uint32_t read(uint32_t rgn_start, uint32_t offset, int size);
     void write(uint32_t rgn_start, uint32_t offset, uint32_t value, int size);
+    MMIOHandlerTable* get_mmio_handlers(uint32_t rgn_start) { return &this->mmio_handlers; };
 
     // InterruptCtrl methods
     uint32_t register_dev_int(IntSrc src_id);
@@ -240,6 +245,8 @@ private:
     NVram*              nvram;   // NVRAM module
     ViaCuda*            viacuda; // VIA cell with Cuda MCU attached to it
     EsccController*     escc;    // ESCC serial controller
+
+    MMIOHandlerTable    mmio_handlers{"OHare"};
 };
 
 /**
@@ -348,6 +355,7 @@ public:
     // MMIO device methods
     uint32_t read(uint32_t rgn_start, uint32_t offset, int size);
     void write(uint32_t rgn_start, uint32_t offset, uint32_t value, int size);
+    MMIOHandlerTable* get_mmio_handlers(uint32_t rgn_start) { return &this->mmio_handlers; };
 
     // InterruptCtrl methods
     uint32_t register_dev_int(IntSrc src_id);
@@ -405,6 +413,8 @@ private:
     std::unique_ptr<DMAChannel>     enet_xmit_dma;
     std::unique_ptr<DMAChannel>     enet_rcv_dma;
     std::unique_ptr<DMAChannel>     snd_out_dma;
+
+    MMIOHandlerTable    mmio_handlers{"Heathrow"};
 };
 
 #endif /* MACIO_H */
@@ -56,6 +56,22 @@ OHare::OHare() : PCIDevice("mac-io/ohare"), InterruptCtrl()
     // connect Cuda
     this->viacuda = dynamic_cast<ViaCuda*>(gMachineObj->get_comp_by_name("ViaCuda"));
 
+    // let the MMU call the handlers of the most frequently polled registers directly
+    this->mmio_handlers.add_reg("CTRL", 0, 0x1000, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) {
+            return this->read_ctrl(offset, size);
+        },
+        [this](uint32_t offset, uint32_t value, int size) {
+            this->write_ctrl(offset, value, size);
+        });
+    this->mmio_handlers.add_reg("VIA-CUDA", 0x16000, 0x2000, MMIO_ACC_ANY,
+        [this](uint32_t offset, int size) {
+            return this->viacuda->read((offset >> 9) & 0xF);
+        },
+        [this](uint32_t offset, uint32_t value, int size) {
+            this->viacuda->write((offset >> 9) & 0xF, value);
+        });
+
     // initialize sound chip and its DMA output channel, then wire them together
     this->awacs       = std::unique_ptr<AwacsScreamer> (new AwacsScreamer());
     this->snd_out_dma = std::unique_ptr<DMAChannel> (new DMAChannel("snd_out"));
@@ -0,0 +1,346 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Host-mapped guest physical address space. */
+
+#include <devices/memctrl/fastmem.h>
+#include <devices/memctrl/memctrlbase.h>
+#include <devices/common/mmiohandlers.h>
+#include <loguru.hpp>
+
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+
+#ifdef HAVE_FASTMEM
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+bool     fastmem_enabled = true;
+uint8_t* fastmem_base    = nullptr;
+uint32_t fastmem_page_bits[1 << (32 - FASTMEM_PAGE_BITS - 5)];
+
+#ifdef HAVE_FASTMEM
+
+constexpr uint64_t FASTMEM_SIZE = 1ULL << 32;
+
+typedef struct FastMemAlloc {
+    uint8_t*    host_ptr;   // where the memory is accessible outside the window
+    uint32_t    size;
+    int         fd;         // memory file backing both mappings
+} FastMemAlloc;
+
+static MemCtrlBase*              owner = nullptr;
+static std::vector<FastMemAlloc> allocs;
+static struct sigaction          prev_segv_action;
+
+/** Instructions that may access the window. The data is always in RAX. */
+typedef struct FastMemInstr {
+    uint8_t     bytes[4];
+    uint8_t     len;
+    uint8_t     size;
+    bool        is_store;
+} FastMemInstr;
+
+static const FastMemInstr fastmem_instrs[] = {
+    // fastmem_load/fastmem_store, (%rdi,%rsi) addressing
+    {{0x0F, 0xB6, 0x04, 0x37}, 4, 1, false}, // movzbl (%rdi,%rsi), %eax
+    {{0x0F, 0xB7, 0x04, 0x37}, 4, 2, false}, // movzwl (%rdi,%rsi), %eax
+    {{0x8B, 0x04, 0x37},       3, 4, false}, // movl   (%rdi,%rsi), %eax
+    {{0x48, 0x8B, 0x04, 0x37}, 4, 8, false}, // movq   (%rdi,%rsi), %rax
+    {{0x88, 0x04, 0x37},       3, 1, true},  // movb   %al,  (%rdi,%rsi)
+    {{0x66, 0x89, 0x04, 0x37}, 4, 2, true},  // movw   %ax,  (%rdi,%rsi)
+    {{0x89, 0x04, 0x37},       3, 4, true},  // movl   %eax, (%rdi,%rsi)
+    {{0x48, 0x89, 0x04, 0x37}, 4, 8, true},  // movq   %rax, (%rdi,%rsi)
+    // accesses emitted by the recompiler, (%rcx) addressing
+    {{0x0F, 0xB6, 0x01},       3, 1, false}, // movzbl (%rcx), %eax
+    {{0x0F, 0xB7, 0x01},       3, 2, false}, // movzwl (%rcx), %eax
+    {{0x8B, 0x01},             2, 4, false}, // movl   (%rcx), %eax
+    {{0x88, 0x01},             2, 1, true},  // movb   %al,  (%rcx)
+    {{0x66, 0x89, 0x01},       3, 2, true},  // movw   %ax,  (%rcx)
+    {{0x89, 0x01},             2, 4, true},  // movl   %eax, (%rcx)
+};
+
+static inline uint64_t swap_sized(uint64_t val, int size) {
+    switch (size) {
+    case 2:
+        return BYTESWAP_16((uint16_t)val);
+    case 4:
+        return BYTESWAP_32((uint32_t)val);
+    case 8:
+        return BYTESWAP_64(val);
+    case 1:
+        return (uint8_t)val;
+    default:
+        return val;
+    }
+}
+
+// Emulates a load from an inaccessible part of the window.
+// Returns the data the way a plain host load would have left it in RAX.
+static uint64_t fastmem_emu_load(uint32_t addr, int size) {
+    AddressMapEntry* entry = owner->find_range(addr);
+    uint64_t val = 0;
+
+    if (!entry)
+        return ~0ULL >> (64 - size * 8); // unmapped physical memory reads as all ones
+
+    uint32_t offset = addr - entry->start;
+
+    if (entry->type & RT_MMIO) {
+        if (size == 8) {
+            val = ((uint64_t)mmio_read(entry, offset, 4) << 32) | mmio_read(entry, offset + 4, 4);
+        } else {
+            val = mmio_read(entry, offset, size);
+        }
+        return swap_sized(val, size);
+    }
+
+    // memory that couldn't be mapped into the window with host page granularity
+    std::memcpy(&val, entry->mem_ptr + offset, size);
+    return val;
+}
+
+// Emulates a store to an inaccessible part of the window.
+static void fastmem_emu_store(uint32_t addr, uint64_t raw, int size) {
+    AddressMapEntry* entry = owner->find_range(addr);
+
+    if (!entry || (entry->type & RT_ROM))
+        return; // writes to unmapped space and ROM are dropped
+
+    uint32_t offset = addr - entry->start;
+
+    if (entry->type & RT_MMIO) {
+        uint64_t val = swap_sized(raw, size);
+        if (size == 8) {
+            mmio_write(entry, offset, (uint32_t)(val >> 32), 4);
+            mmio_write(entry, offset + 4, (uint32_t)val, 4);
+        } else {
+            mmio_write(entry, offset, (uint32_t)val, size);
+        }
+    } else {
+        std::memcpy(entry->mem_ptr + offset, &raw, size);
+    }
+}
+
+static void fastmem_segv_handler(int sig, siginfo_t* info, void* uctx) {
+    greg_t*  regs       = ((ucontext_t*)uctx)->uc_mcontext.gregs;
+    uint8_t* fault_addr = (uint8_t*)info->si_addr;
+
+    // fastmem accesses are naturally aligned so the fault address
+    // is the address of the access itself
+    if (fastmem_base && fault_addr >= fastmem_base &&
+        fault_addr < fastmem_base + FASTMEM_SIZE) {
+        const uint8_t* rip = (const uint8_t*)regs[REG_RIP];
+        uint32_t addr      = (uint32_t)(fault_addr - fastmem_base);
+
+        for (const FastMemInstr& instr : fastmem_instrs) {
+            if (std::memcmp(rip, instr.bytes, instr.len))
+                continue;
+            if (instr.is_store)
+                fastmem_emu_store(addr, (uint64_t)regs[REG_RAX], instr.size);
+            else
+                regs[REG_RAX] = (greg_t)fastmem_emu_load(addr, instr.size);
+            regs[REG_RIP] += instr.len;
+            return;
+        }
+    }
+
+    // not a fastmem access, leave it to whoever was there before us
+    if (prev_segv_action.sa_flags & SA_SIGINFO) {
+        prev_segv_action.sa_sigaction(sig, info, uctx);
+    } else if (prev_segv_action.sa_handler == SIG_DFL ||
+               prev_segv_action.sa_handler == SIG_IGN) {
+        // the faulting instruction will be retried and crash for real
+        signal(sig, SIG_DFL);
+    } else {
+        prev_segv_action.sa_handler(sig);
+    }
+}
+
+bool fastmem_init(MemCtrlBase* mem_ctrl) {
+    if (owner)
+        return owner == mem_ctrl;
+
+    if (!fastmem_enabled)
+        return false;
+
+    void* base = mmap(nullptr, FASTMEM_SIZE, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        LOG_F(WARNING, "Fastmem: couldn't reserve guest physical window");
+        return false;
+    }
+
+    struct sigaction sa = {};
+    sa.sa_sigaction = fastmem_segv_handler;
+    sa.sa_flags     = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGSEGV, &sa, &prev_segv_action)) {
+        LOG_F(WARNING, "Fastmem: couldn't install SIGSEGV handler");
+        munmap(base, FASTMEM_SIZE);
+        return false;
+    }
+
+    fastmem_base = (uint8_t*)base;
+    owner        = mem_ctrl;
+
+    LOG_F(INFO, "Fastmem: guest physical window at %p", base);
+
+    return true;
+}
+
+void fastmem_exit(MemCtrlBase* mem_ctrl) {
+    if (!owner || owner != mem_ctrl)
+        return;
+
+    for (auto& alloc : allocs) {
+        munmap(alloc.host_ptr, alloc.size);
+        close(alloc.fd);
+    }
+    allocs.clear();
+    std::memset(fastmem_page_bits, 0, sizeof(fastmem_page_bits));
+
+    munmap(fastmem_base, FASTMEM_SIZE);
+    sigaction(SIGSEGV, &prev_segv_action, nullptr);
+
+    fastmem_base = nullptr;
+    owner        = nullptr;
+}
+
+MemCtrlBase* fastmem_owner() {
+    return owner;
+}
+
+static inline bool is_page_aligned(uint64_t val) {
+    return !(val & (sysconf(_SC_PAGESIZE) - 1));
+}
+
+static void mark_mem_pages(uint32_t guest_pa, uint32_t size, bool is_mem = true) {
+    for (uint64_t addr = guest_pa; addr < (uint64_t)guest_pa + size; addr += 1 << FASTMEM_PAGE_BITS) {
+        uint32_t page_num = (uint32_t)(addr >> FASTMEM_PAGE_BITS);
+        if (is_mem)
+            fastmem_page_bits[page_num >> 5] |= 1U << (page_num & 31);
+        else
+            fastmem_page_bits[page_num >> 5] &= ~(1U << (page_num & 31));
+    }
+}
+
+uint8_t* fastmem_alloc(uint32_t guest_pa, uint32_t size, bool read_only) {
+    if (!owner || !size || !is_page_aligned(guest_pa) || !is_page_aligned(size))
+        return nullptr;
+
+    int fd = memfd_create("dppc-guest-mem", MFD_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+
+    if (ftruncate(fd, size)) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* host_ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (host_ptr == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    if (mmap(fastmem_base + guest_pa, size, read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(host_ptr, size);
+        close(fd);
+        return nullptr;
+    }
+
+    allocs.push_back({(uint8_t*)host_ptr, size, fd});
+    mark_mem_pages(guest_pa, size);
+
+    return (uint8_t*)host_ptr;
+}
+
+bool fastmem_map_mirror(uint32_t guest_pa, uint8_t* host_ptr, uint32_t size, bool read_only) {
+    if (!owner || !size || !is_page_aligned(guest_pa) || !is_page_aligned(size))
+        return false;
+
+    for (auto& alloc : allocs) {
+        if (host_ptr < alloc.host_ptr || host_ptr + size > alloc.host_ptr + alloc.size)
+            continue;
+
+        uint32_t offset = (uint32_t)(host_ptr - alloc.host_ptr);
+        if (!is_page_aligned(offset))
+            return false;
+
+        if (mmap(fastmem_base + guest_pa, size, read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED, alloc.fd, offset) == MAP_FAILED)
+            return false;
+
+        mark_mem_pages(guest_pa, size);
+        return true;
+    }
+
+    return false;
+}
+
+void fastmem_unmap(uint32_t guest_pa, uint32_t size) {
+    if (!owner || !size)
+        return;
+
+    // clear the page bits first so users take the regular path from now on
+    mark_mem_pages(guest_pa, size, false);
+
+    // round outwards to host pages, partial pages were never mapped
+    uint64_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+    uint64_t start     = guest_pa & ~page_mask;
+    uint64_t end       = ((uint64_t)guest_pa + size + page_mask) & ~page_mask;
+
+    if (mmap(fastmem_base + start, end - start, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED)
+        LOG_F(ERROR, "Fastmem: couldn't unmap 0x%X..0x%X", guest_pa, guest_pa + size - 1);
+}
+
+#else
+
+bool fastmem_init(MemCtrlBase* mem_ctrl) {
+    return false;
+}
+
+void fastmem_exit(MemCtrlBase* mem_ctrl) {
+}
+
+MemCtrlBase* fastmem_owner() {
+    return nullptr;
+}
+
+uint8_t* fastmem_alloc(uint32_t guest_pa, uint32_t size, bool read_only) {
+    return nullptr;
+}
+
+bool fastmem_map_mirror(uint32_t guest_pa, uint8_t* host_ptr, uint32_t size, bool read_only) {
+    return false;
+}
+
+void fastmem_unmap(uint32_t guest_pa, uint32_t size) {
+}
+
+#endif // HAVE_FASTMEM
@@ -0,0 +1,152 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-24 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Host-mapped guest physical address space ("fastmem").
+
+    A 4 GiB range of host address space is reserved and RAM/ROM regions
+    of the owning memory controller are mapped into it at their guest
+    physical addresses, so that guest physical address X can be accessed
+    at fastmem_base + X. ROM is mapped read-only, everything else (MMIO
+    regions and unmapped space) stays inaccessible.
+
+    Pages backed by memory in the window are tracked in fastmem_page_bits.
+    Users are expected to check it and route other accesses through their
+    regular path: taking a signal costs microseconds, so dispatching MMIO
+    through faults would make polling a device register orders of magnitude
+    slower than a TLB hit.
+
+    Accesses that fault anyway (ROM writes, or MMIO reached without checking
+    the page bits) are emulated by a SIGSEGV handler. It dispatches to the
+    MMIO device behind the address, drops ROM writes and reads all ones from
+    unmapped space, then resumes after the faulting instruction. To make that
+    possible, all accesses to the window must be done using the fastmem_load/
+    fastmem_store helpers below or the recompiler's equivalent. They use fixed
+    instruction encodings the handler knows about.
+
+    Only available on Linux x86-64. Elsewhere, or if the reservation fails,
+    fastmem_base stays nullptr and regions are allocated on the heap.
+ */
+
+#ifndef FASTMEM_H
+#define FASTMEM_H
+
+#include <endianswap.h>
+
+#include <cinttypes>
+
+#if defined(__linux__) && defined(__x86_64__)
+#define HAVE_FASTMEM
+#endif
+
+class MemCtrlBase;
+
+/** Tells whether memory controllers may use fastmem. */
+extern bool fastmem_enabled;
+
+/** Base of the guest physical window, nullptr if unavailable. */
+extern uint8_t* fastmem_base;
+
+#define FASTMEM_PAGE_BITS   12
+
+/** One bit per 4 KB guest physical page, set if the page is backed by
+    memory in the window. */
+extern uint32_t fastmem_page_bits[1 << (32 - FASTMEM_PAGE_BITS - 5)];
+
+inline bool fastmem_is_mem_page(uint32_t addr) {
+    uint32_t page_num = addr >> FASTMEM_PAGE_BITS;
+    return (fastmem_page_bits[page_num >> 5] >> (page_num & 31)) & 1;
+}
+
+/** Reserves the window for mem_ctrl. Fails if it's unsupported
+    or already owned by another memory controller. */
+extern bool fastmem_init(MemCtrlBase* mem_ctrl);
+
+/** Releases the window and all memory allocated through it. */
+extern void fastmem_exit(MemCtrlBase* mem_ctrl);
+
+/** Returns the memory controller owning the window. */
+extern MemCtrlBase* fastmem_owner();
+
+/** Allocates zeroed host memory for a guest memory region and makes it
+    accessible at guest_pa in the window. Returns nullptr on failure. */
+extern uint8_t* fastmem_alloc(uint32_t guest_pa, uint32_t size, bool read_only);
+
+/** Makes size bytes of memory previously returned by fastmem_alloc,
+    starting at host_ptr, accessible at guest_pa in the window as well.
+    Returns false if that isn't possible with host page granularity. */
+extern bool fastmem_map_mirror(uint32_t guest_pa, uint8_t* host_ptr, uint32_t size,
+                               bool read_only);
+
+/** Makes size bytes at guest_pa inaccessible in the window again. The memory
+    behind them stays valid and may be mapped elsewhere using
+    fastmem_map_mirror. */
+extern void fastmem_unmap(uint32_t guest_pa, uint32_t size);
+
+#ifdef HAVE_FASTMEM
+
+/* The encodings used here are recognized by the fault handler:
+   RDI holds the window base, RSI the guest physical address and
+   RAX/EAX/AX/AL the data. Don't change them without updating
+   the table in fastmem.cpp. */
+
+template <class T>
+inline T fastmem_load(uint8_t* base, uint32_t addr) {
+    uint64_t val;
+
+    switch (sizeof(T)) {
+    case 1:
+        asm volatile("movzbl (%%rdi,%%rsi), %%eax" : "=a"(val) : "D"(base), "S"((uint64_t)addr) : "memory");
+        return (T)val;
+    case 2:
+        asm volatile("movzwl (%%rdi,%%rsi), %%eax" : "=a"(val) : "D"(base), "S"((uint64_t)addr) : "memory");
+        return (T)BYTESWAP_16((uint16_t)val);
+    case 4:
+        asm volatile("movl (%%rdi,%%rsi), %%eax" : "=a"(val) : "D"(base), "S"((uint64_t)addr) : "memory");
+        return (T)BYTESWAP_32((uint32_t)val);
+    default:
+        asm volatile("movq (%%rdi,%%rsi), %%rax" : "=a"(val) : "D"(base), "S"((uint64_t)addr) : "memory");
+        return (T)BYTESWAP_64(val);
+    }
+}
+
+template <class T>
+inline void fastmem_store(uint8_t* base, uint32_t addr, T value) {
+    switch (sizeof(T)) {
+    case 1:
+        asm volatile("movb %%al, (%%rdi,%%rsi)" : : "a"((uint64_t)value), "D"(base), "S"((uint64_t)addr) : "memory");
+        break;
+    case 2:
+        asm volatile("movw %%ax, (%%rdi,%%rsi)" : : "a"((uint64_t)BYTESWAP_16((uint16_t)value)),
+                     "D"(base), "S"((uint64_t)addr) : "memory");
+        break;
+    case 4:
+        asm volatile("movl %%eax, (%%rdi,%%rsi)" : : "a"((uint64_t)BYTESWAP_32((uint32_t)value)),
+                     "D"(base), "S"((uint64_t)addr) : "memory");
+        break;
+    default:
+        asm volatile("movq %%rax, (%%rdi,%%rsi)" : : "a"((uint64_t)BYTESWAP_64((uint64_t)value)),
+                     "D"(base), "S"((uint64_t)addr) : "memory");
+    }
+}
+
+#endif // HAVE_FASTMEM
+
+#endif // FASTMEM_H
@@ -92,11 +92,7 @@ void HMC::remap_ram_regions() {
     }
 
     if (this->bank_b_size && this->bank_b_start != bank_b_addr) {
-        AddressMapEntry *ref_entry = find_range(this->bank_b_start);
-        if (ref_entry) {
-            ref_entry->end   = bank_b_addr + (ref_entry->end - ref_entry->start);
-            ref_entry->start = bank_b_addr;
-
+        if (this->move_mem_region(this->bank_b_start, bank_b_addr)) {
             this->bank_b_start = bank_b_addr;
             LOG_F(INFO, "%s: successfully relocated bank B mem region to 0x%X",
                   this->name.c_str(), bank_b_addr);
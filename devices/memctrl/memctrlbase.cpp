@@ -20,6 +20,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <devices/memctrl/memctrlbase.h>
+#include <devices/memctrl/fastmem.h>
 #include <devices/common/mmiodevice.h>
 
 #include <algorithm>
@@ -28,18 +29,56 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <vector>
 #include <loguru.hpp>
 
+uint32_t vram_dirty_bits[1 << (32 - VRAM_PAGE_BITS - 5)];
+
+void vram_mark_dirty(uint32_t addr, uint32_t size) {
+    if (!size)
+        return;
+
+    uint32_t last_page = (uint32_t)(((uint64_t)addr + size - 1) >> VRAM_PAGE_BITS);
+    for (uint32_t page_num = addr >> VRAM_PAGE_BITS; page_num <= last_page; page_num++)
+        vram_dirty_bits[page_num >> 5] |= 1U << (page_num & 31);
+}
+
+bool vram_test_and_clear_dirty(uint32_t addr, uint32_t size) {
+    bool dirty = false;
+
+    if (!size)
+        return false;
+
+    uint32_t last_page = (uint32_t)(((uint64_t)addr + size - 1) >> VRAM_PAGE_BITS);
+    for (uint32_t page_num = addr >> VRAM_PAGE_BITS; page_num <= last_page; page_num++) {
+        uint32_t mask = 1U << (page_num & 31);
+        if (vram_dirty_bits[page_num >> 5] & mask) {
+            vram_dirty_bits[page_num >> 5] &= ~mask;
+            dirty = true;
+        }
+    }
+
+    return dirty;
+}
+
+MemCtrlBase::MemCtrlBase() {
+    this->rebuild_page_map(); // start with an empty directory
+}
+
 MemCtrlBase::~MemCtrlBase() {
     for (auto& entry : address_map) {
         if (entry)
             delete(entry);
     }
 
+    for (auto& entry : dead_entries)
+        delete(entry);
+
     for (auto& reg : mem_regions) {
         if (reg)
             delete (reg);
     }
     this->mem_regions.clear();
     this->address_map.clear();
+
+    fastmem_exit(this);
 }
 
 
@@ -52,16 +91,126 @@ static inline bool match_mem_entry(const AddressMapEntry* entry,
 }
 
 
+constexpr int      PAGE_MAP_PAGE_BITS  = 12;
+constexpr int      PAGE_MAP_CHUNK_BITS = 22;
+constexpr uint32_t PAGE_MAP_PAGE_MASK  = (1 << PAGE_MAP_PAGE_BITS) - 1;
+constexpr uint32_t PAGE_MAP_PAGES      = 1 << (PAGE_MAP_CHUNK_BITS - PAGE_MAP_PAGE_BITS);
+
 AddressMapEntry* MemCtrlBase::find_range(uint32_t addr) {
-    for (auto& entry : address_map) {
-        if (addr >= entry->start && addr <= entry->end)
-            return entry;
+    PageDir* dir = this->page_dir.load();
+
+    const uint32_t* pages = dir->page_map[addr >> PAGE_MAP_CHUNK_BITS].get();
+    if (!pages)
+        return nullptr;
+
+    uint32_t list_idx = pages[(addr >> PAGE_MAP_PAGE_BITS) & (PAGE_MAP_PAGES - 1)];
+    for (AddressMapEntry** entry = &dir->rgn_lists[list_idx]; *entry; entry++) {
+        if (addr >= (*entry)->start && addr <= (*entry)->end)
+            return *entry;
     }
 
     return nullptr;
 }
 
 
+void MemCtrlBase::rebuild_page_map() {
+    if (this->map_updates) {
+        this->page_map_stale = true; // done by end_map_update()
+        return;
+    }
+
+    // build the new directory aside, async lookups may be using the current one
+    PageDir* dir = new PageDir;
+
+    dir->rgn_lists.assign(1, nullptr); // index 0 is the empty list
+
+    auto set_page = [dir](uint64_t page_num, uint32_t list_idx) {
+        auto& pages = dir->page_map[page_num >> (PAGE_MAP_CHUNK_BITS - PAGE_MAP_PAGE_BITS)];
+        if (!pages)
+            pages.reset(new uint32_t[PAGE_MAP_PAGES]());
+        pages[page_num & (PAGE_MAP_PAGES - 1)] = list_idx;
+    };
+
+    // regions covering an address only change at region boundaries
+    std::vector<uint64_t> bounds;
+    for (auto& entry : address_map) {
+        bounds.push_back(entry->start);
+        bounds.push_back((uint64_t)entry->end + 1);
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    // pages lying between two boundaries resolve to a single region
+    for (size_t i = 0; i + 1 < bounds.size(); i++) {
+        uint64_t first_page = (bounds[i] + PAGE_MAP_PAGE_MASK) >> PAGE_MAP_PAGE_BITS;
+        uint64_t end_page   = bounds[i + 1] >> PAGE_MAP_PAGE_BITS;
+        if (first_page >= end_page)
+            continue;
+
+        auto it = std::find_if(address_map.begin(), address_map.end(),
+            [addr = bounds[i]](const AddressMapEntry* entry) {
+                return addr >= entry->start && addr <= entry->end;
+            });
+        if (it == address_map.end())
+            continue;
+
+        uint32_t list_idx = (uint32_t)dir->rgn_lists.size();
+        dir->rgn_lists.push_back(*it);
+        dir->rgn_lists.push_back(nullptr);
+
+        for (uint64_t page_num = first_page; page_num < end_page; page_num++)
+            set_page(page_num, list_idx);
+    }
+
+    // pages split by a boundary need all regions touching them
+    uint64_t prev_page = ~0ULL;
+    for (uint64_t bound : bounds) {
+        uint64_t page_num = bound >> PAGE_MAP_PAGE_BITS;
+        if (!(bound & PAGE_MAP_PAGE_MASK) || page_num == prev_page)
+            continue;
+        prev_page = page_num;
+
+        uint32_t page_start = (uint32_t)(page_num << PAGE_MAP_PAGE_BITS);
+        uint32_t page_end   = page_start + PAGE_MAP_PAGE_MASK;
+        uint32_t list_idx   = (uint32_t)dir->rgn_lists.size();
+
+        for (auto& entry : address_map) {
+            if (page_end < entry->start || page_start > entry->end)
+                continue;
+            dir->rgn_lists.push_back(entry);
+            if (page_start >= entry->start && page_end <= entry->end)
+                break; // regions after this one can't be reached
+        }
+
+        if (dir->rgn_lists.size() > list_idx) {
+            dir->rgn_lists.push_back(nullptr);
+            set_page(page_num, list_idx);
+        }
+    }
+
+    this->page_dir.store(dir);
+    this->page_dirs.emplace_back(dir);
+
+    // lookups starting from now on see the new directory, those
+    // already in progress keep the old ones alive until a later rebuild
+    if (!this->async_lookups.load()) {
+        this->page_dirs.erase(this->page_dirs.begin(), this->page_dirs.end() - 1);
+        for (auto& entry : this->dead_entries)
+            delete(entry);
+        this->dead_entries.clear();
+    }
+}
+
+
+void MemCtrlBase::end_map_update() {
+    if (--this->map_updates || !this->page_map_stale)
+        return;
+
+    this->page_map_stale = false;
+    this->rebuild_page_map();
+}
+
+
 AddressMapEntry* MemCtrlBase::find_range_exact(uint32_t addr, uint32_t size,
                                                MMIODevice* dev_instance)
 {
@@ -80,6 +229,12 @@ AddressMapEntry* MemCtrlBase::find_range_exact(uint32_t addr, uint32_t size,
 AddressMapEntry* MemCtrlBase::find_range_contains(uint32_t addr, uint32_t size) {
     if (size) {
         uint32_t end = addr + size - 1;
+
+        // the first region containing addr is usually the one
+        AddressMapEntry* entry = find_range(addr);
+        if (entry && end <= entry->end)
+            return entry;
+
         for (auto& entry : address_map) {
             if (addr >= entry->start && end <= entry->end)
                 return entry;
@@ -154,9 +309,15 @@ bool MemCtrlBase::add_mem_region(uint32_t start_addr, uint32_t size,
     if (!is_range_free(start_addr, size))
         return false;
 
-    uint8_t* reg_content = new uint8_t[size](); // allocate and clear to zero
+    // make the region directly accessible at its physical address if possible
+    uint8_t* reg_content = nullptr;
+    if (fastmem_init(this))
+        reg_content = fastmem_alloc(start_addr, size, type == RT_ROM);
 
-    this->mem_regions.push_back(reg_content);
+    if (!reg_content) {
+        reg_content = new uint8_t[size](); // allocate and clear to zero
+        this->mem_regions.push_back(reg_content);
+    }
 
     entry = new AddressMapEntry;
 
@@ -167,8 +328,10 @@ bool MemCtrlBase::add_mem_region(uint32_t start_addr, uint32_t size,
     entry->type    = type;
     entry->devobj  = nullptr;
     entry->mem_ptr = reg_content;
+    entry->handlers = nullptr;
 
     this->address_map.push_back(entry);
+    this->rebuild_page_map();
 
     LOG_F(INFO, "Added mem region 0x%X..0x%X (%s%s%s%s) -> 0x%X", start_addr, end,
         entry->type & RT_ROM ? "ROM," : "",
@@ -219,8 +382,14 @@ bool MemCtrlBase::add_mem_mirror_common(uint32_t start_addr, uint32_t dest_addr,
     entry->type    = ref_entry->type | RT_MIRROR;
     entry->devobj  = nullptr;
     entry->mem_ptr = ref_entry->mem_ptr + offset;
+    entry->handlers = nullptr;
+
+    // mirrors hidden by existing regions stay out of the fastmem window
+    if (fastmem_owner() == this && !find_range_overlaps(start_addr, size))
+        fastmem_map_mirror(start_addr, entry->mem_ptr, size, entry->type & RT_ROM);
 
     this->address_map.push_back(entry);
+    this->rebuild_page_map();
 
     LOG_F(INFO, "Added mem region mirror 0x%X..0x%X (%s%s%s%s) -> 0x%X : 0x%X..0x%X%s%s%s",
         start_addr, end,
@@ -251,6 +420,32 @@ bool MemCtrlBase::add_mem_mirror_partial(uint32_t start_addr, uint32_t dest_addr
 }
 
 
+bool MemCtrlBase::move_mem_region(uint32_t start_addr, uint32_t new_start) {
+    AddressMapEntry* entry = find_range(start_addr);
+    if (!entry || entry->start != start_addr || !(entry->type & (RT_RAM | RT_ROM)))
+        return false;
+
+    uint32_t size = entry->end - entry->start + 1;
+
+    // the content stays where it is, only the window mapping moves along
+    if (fastmem_owner() == this) {
+        fastmem_unmap(start_addr, size);
+        fastmem_map_mirror(new_start, entry->mem_ptr, size, entry->type & RT_ROM);
+    }
+
+    // async lookups may still look at the old entry, replace it by a copy
+    AddressMapEntry* new_entry = new AddressMapEntry(*entry);
+    new_entry->start = new_start;
+    new_entry->end   = new_start + size - 1;
+
+    std::replace(this->address_map.begin(), this->address_map.end(), entry, new_entry);
+    this->dead_entries.push_back(entry);
+    this->rebuild_page_map();
+
+    return true;
+}
+
+
 bool MemCtrlBase::set_data(uint32_t load_addr, const uint8_t* data, uint32_t size) {
     AddressMapEntry* ref_entry;
     uint32_t cpy_size;
@@ -285,8 +480,10 @@ bool MemCtrlBase::add_mmio_region(uint32_t start_addr, uint32_t size, MMIODevice
     entry->type    = RT_MMIO;
     entry->devobj  = dev_instance;
     entry->mem_ptr = 0;
+    entry->handlers = dev_instance ? dev_instance->get_mmio_handlers(start_addr) : nullptr;
 
     this->address_map.push_back(entry);
+    this->rebuild_page_map();
 
     LOG_F(INFO, "Added mmio region 0x%X..0x%X%s%s%s",
         start_addr, end,
@@ -312,6 +509,9 @@ bool MemCtrlBase::remove_mmio_region(uint32_t start_addr, uint32_t size, MMIODev
         }
     ), address_map.end());
 
+    if (found)
+        this->rebuild_page_map();
+
     if (found == 0)
         LOG_F(ERROR, "Cannot find mmio region 0x%X..0x%X%s%s%s to remove",
             start_addr, end,
@@ -340,6 +540,64 @@ bool MemCtrlBase::remove_mmio_region(uint32_t start_addr, uint32_t size, MMIODev
     return (found > 0);
 }
 
+bool MemCtrlBase::add_vram_region(uint32_t start_addr, uint32_t size, uint8_t* host_ptr)
+{
+    uint32_t end = start_addr + size - 1;
+
+    // VRAM regions are looked up before everything added after them,
+    // so they may only be laid over a single MMIO region
+    AddressMapEntry* parent = find_range_overlaps(start_addr, size);
+    if (parent && (!(parent->type & RT_MMIO) || start_addr < parent->start ||
+        end > parent->end)) {
+        LOG_F(ERROR, "VRAM region 0x%X..0x%X overlaps memory region 0x%X..0x%X",
+              start_addr, end, parent->start, parent->end);
+        return false;
+    }
+
+    AddressMapEntry* entry = new AddressMapEntry;
+
+    entry->start   = start_addr;
+    entry->end     = end;
+    entry->mirror  = 0;
+    entry->type    = RT_RAM | RT_VRAM;
+    entry->devobj  = nullptr;
+    entry->mem_ptr = host_ptr;
+    entry->handlers = nullptr;
+
+    this->address_map.insert(this->address_map.begin(), entry);
+    this->rebuild_page_map();
+
+    MMIODevice* dev_instance = parent ? parent->devobj : nullptr;
+
+    LOG_F(INFO, "Added VRAM region 0x%X..0x%X%s%s%s", start_addr, end,
+        dev_instance ? " over (" : "",
+            dev_instance ? dev_instance->get_name().c_str() : "",
+            dev_instance ? ")"
+            : ""
+    );
+
+    return true;
+}
+
+bool MemCtrlBase::remove_vram_region(uint32_t start_addr, uint32_t size)
+{
+    uint32_t end = start_addr + size - 1;
+
+    for (auto it = address_map.begin(); it != address_map.end(); ++it) {
+        AddressMapEntry* entry = *it;
+        if ((entry->type & RT_VRAM) && match_mem_entry(entry, start_addr, end, nullptr)) {
+            address_map.erase(it);
+            this->dead_entries.push_back(entry);
+            this->rebuild_page_map();
+            LOG_F(INFO, "Removed VRAM region 0x%X..0x%X", start_addr, end);
+            return true;
+        }
+    }
+
+    LOG_F(ERROR, "Cannot find VRAM region 0x%X..0x%X to remove", start_addr, end);
+    return false;
+}
+
 AddressMapEntry* MemCtrlBase::find_rom_region()
 {
     for (auto& entry : address_map) {
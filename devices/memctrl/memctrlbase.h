@@ -22,11 +22,14 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef MEMORY_CONTROLLER_BASE_H
 #define MEMORY_CONTROLLER_BASE_H
 
+#include <atomic>
 #include <cinttypes>
+#include <memory>
 #include <string>
 #include <vector>
 
 class MMIODevice;
+class MMIOHandlerTable;
 
 /* Common DRAM capacities. */
 enum {
@@ -44,10 +47,29 @@ enum RangeType {
     RT_ROM    = 1, // read-only memory
     RT_RAM    = 2, // random access memory
     RT_MMIO   = 4, // memory mapped I/O
-    RT_MIRROR = 8  // region mirror (content of another region acessible at some
+    RT_MIRROR = 8, // region mirror (content of another region acessible at some
                    // other address)
+    RT_VRAM   = 16 // video memory, writes are tracked in vram_dirty_bits
 };
 
+/** One bit per 4 KB guest physical page of video memory mapped with
+    add_vram_region(), set when the page is written to by the CPU or DMA.
+    Video controllers clear it once they have picked up the changes. */
+#define VRAM_PAGE_BITS  12
+
+extern uint32_t vram_dirty_bits[1 << (32 - VRAM_PAGE_BITS - 5)];
+
+inline void vram_mark_dirty(uint32_t addr) {
+    uint32_t page_num = addr >> VRAM_PAGE_BITS;
+    vram_dirty_bits[page_num >> 5] |= 1U << (page_num & 31);
+}
+
+extern void vram_mark_dirty(uint32_t addr, uint32_t size);
+
+/** Tells whether any page of the given range has been written to
+    and clears the corresponding dirty bits. */
+extern bool vram_test_and_clear_dirty(uint32_t addr, uint32_t size);
+
 /** Defines the format for the address map entry. */
 typedef struct AddressMapEntry {
     uint32_t start;         // first address of the corresponding range
@@ -56,13 +78,14 @@ typedef struct AddressMapEntry {
     uint32_t type;          // range type
     MMIODevice* devobj;     // pointer to device object
     unsigned char* mem_ptr; // direct pointer to data for memory objects
+    MMIOHandlerTable* handlers; // register handlers of the device, may be nullptr
 } AddressMapEntry;
 
 
 /** Base class for memory controllers. */
 class MemCtrlBase {
 public:
-    MemCtrlBase() = default;
+    MemCtrlBase();
     virtual ~MemCtrlBase();
     virtual bool add_rom_region(uint32_t start_addr, uint32_t size);
     virtual bool add_ram_region(uint32_t start_addr, uint32_t size);
@@ -75,9 +98,24 @@ public:
     virtual bool remove_mmio_region(uint32_t start_addr, uint32_t size,
                                     MMIODevice* dev_instance);
 
+    // VRAM regions may be laid over MMIO regions, taking precedence over them
+    virtual bool add_vram_region(uint32_t start_addr, uint32_t size, uint8_t* host_ptr);
+    virtual bool remove_vram_region(uint32_t start_addr, uint32_t size);
+
     virtual bool set_data(uint32_t reg_addr, const uint8_t* data, uint32_t size);
 
     AddressMapEntry* find_range(uint32_t addr);
+
+    // Threads other than the one changing the address map (e.g. audio DMA)
+    // must bracket their lookups with these so that the page directory and
+    // the regions they are looking at aren't freed meanwhile.
+    void begin_async_lookup() { this->async_lookups++; };
+    void end_async_lookup()   { this->async_lookups--; };
+
+    // Several region changes made between these are applied to the page map
+    // at once. Lookups in between may still see the previous address map.
+    void begin_map_update() { this->map_updates++; };
+    void end_map_update();
     AddressMapEntry* find_range_exact(uint32_t addr, uint32_t size,
                                       MMIODevice* dev_instance);
     AddressMapEntry* find_range_contains(uint32_t addr, uint32_t size);
@@ -97,9 +135,33 @@ protected:
     bool add_mem_mirror_common(uint32_t start_addr, uint32_t dest_addr,
                                uint32_t offset=0, uint32_t size=0);
 
+    // moves the RAM/ROM region starting at start_addr, keeping its content
+    bool move_mem_region(uint32_t start_addr, uint32_t new_start);
+
+    // must be called after changing the address map
+    void rebuild_page_map();
+
 private:
     std::vector<uint8_t*> mem_regions;
     std::vector<AddressMapEntry*> address_map;
+
+    // Page directory for find_range(): 4 MB chunks split into 4 KB pages.
+    // Each page refers to a null-terminated list of the regions touching it
+    // in lookup order, cut after the first region covering the whole page.
+    typedef struct PageDir {
+        std::unique_ptr<uint32_t[]>   page_map[1 << 10];
+        std::vector<AddressMapEntry*> rgn_lists;
+    } PageDir;
+
+    // A rebuilt directory replaces the current one in a single step.
+    // Replaced directories and removed regions are kept until no async
+    // lookup can be using them anymore.
+    std::atomic<PageDir*>                   page_dir{nullptr};
+    std::vector<std::unique_ptr<PageDir>>   page_dirs; // current one last
+    std::vector<AddressMapEntry*>           dead_entries;
+    std::atomic<int>                        async_lookups{0};
+    int                                     map_updates = 0;
+    bool                                    page_map_stale = false;
 };
 
 #endif // MEMORY_CONTROLLER_BASE_H
@@ -55,6 +55,7 @@ PlatinumCtrl::PlatinumCtrl() : MemCtrlBase(), VideoCtrlBase() {
 
     // allocate VRAM
     this->vram_ptr = std::unique_ptr<uint8_t[]> (new uint8_t[this->vram_size]);
+    this->map_vram();
 
     // initialize the CPUID register with the following CPU:
     // PowerPC 601 @ 90 MHz, bus frequency: 45 MHz
@@ -70,8 +71,10 @@ PlatinumCtrl::PlatinumCtrl() : MemCtrlBase(), VideoCtrlBase() {
     };
     this->dacula->set_clut_entry_cb = [this](uint8_t index, uint8_t *colors) {
         this->set_palette_color(index, colors[0], colors[1], colors[2], 0xFF);
+        this->draw_fb = true;
     };
     this->dacula->cursor_ctrl_cb = [this](bool cursor_on) {
+        this->draw_fb = true;
         if (cursor_on) {
             this->dacula->measure_hw_cursor(this->fb_ptr - 16);
             this->cursor_ovl_cb = [this](uint8_t *dst_buf, int dst_pitch) {
@@ -82,6 +85,9 @@ PlatinumCtrl::PlatinumCtrl() : MemCtrlBase(), VideoCtrlBase() {
             this->cursor_ovl_cb = nullptr;
         }
     };
+    this->dacula->cursor_update_cb = [this]() {
+        this->draw_fb = true;
+    };
 }
 
 int PlatinumCtrl::device_postinit() {
@@ -206,6 +212,7 @@ void PlatinumCtrl::write(uint32_t rgn_start, uint32_t offset, uint32_t value, in
     static uint8_t vid_enable_seq[] = {3, 2, 0};
 
     if (rgn_start == VRAM_REGION_BASE) {
+        this->draw_fb = true; // not covered by the VRAM dirty bits
         if (offset < this->vram_size)
             write_mem(&this->vram_ptr[offset], value, size);
         else
@@ -277,7 +284,10 @@ void PlatinumCtrl::write(uint32_t rgn_start, uint32_t offset, uint32_t value, in
         } else
             this->reset_step = 0;
         this->fb_reset = value;
-        this->half_access = !!(this->half_bank && value == 6);
+        if (this->half_access != !!(this->half_bank && value == 6)) {
+            this->half_access = !this->half_access;
+            this->map_vram();
+        }
         break;
     case PlatinumReg::VRAM_REFRESH:
         this->vram_refresh = value;
@@ -380,6 +390,18 @@ void PlatinumCtrl::map_phys_ram() {
 }
 
 // ====================== Framebuffer controller stuff =======================
+
+// Let the CPU access VRAM directly unless reads need to be redirected
+// to emulate a half bank configuration, see read().
+void PlatinumCtrl::map_vram() {
+    this->begin_vram_remap(this);
+
+    if (!this->half_access)
+        this->map_vram_window(VRAM_REGION_BASE, this->vram_size, this->vram_ptr.get());
+
+    this->end_vram_remap();
+}
+
 void PlatinumCtrl::enable_display() {
     int clock_divisor = this->dacula->get_clock_div();
 
@@ -416,6 +438,7 @@ void PlatinumCtrl::enable_display() {
     // set framebuffer parameters
     this->fb_ptr   = &this->vram_ptr[this->fb_offset] + 16;
     this->fb_pitch = this->row_words;
+    this->draw_fb  = true;
 
     this->pixel_depth = this->dacula->get_pix_width();
 
@@ -477,7 +500,7 @@ void PlatinumCtrl::enable_cursor_int() {
         cursor_int_freq,
         [this]() {
             this->update_irq(1, SWATCH_INT_CURSOR); // generate cursor interrupt
-        }
+        }, "Platinum cursor"
     );
 }
 
@@ -224,6 +224,7 @@ protected:
     void enable_display();
     void enable_cursor_int();
     void update_irq(uint8_t irq_line_state, uint8_t irq_mask);
+    void map_vram();
 
 private:
     uint32_t    cpu_id;
@@ -265,7 +266,7 @@ private:
     uint32_t    swatch_int_mask     = 0;
     uint32_t    swatch_int_stat     = 0;
     uint32_t    cursor_line         = 0;
-    uint32_t    cursor_task_id      = 0;
+    uint64_t    cursor_task_id      = 0;
 
     std::unique_ptr<uint8_t[]>      vram_ptr = nullptr;
     std::unique_ptr<DisplayID>      display_id = nullptr;
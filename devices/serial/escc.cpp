@@ -427,7 +427,7 @@ void EsccChannel::dma_in_rx()
                 char c = receive_byte();
                 int xx = dma_ch[1]->push_data(&c, 1);
                 this->dma_in_rx();
-        });
+        }, "ESCC RX");
     }
 }
 
@@ -447,7 +447,7 @@ void EsccChannel::dma_out_tx()
                 }
                 this->dma_out_tx();
             }
-    });
+    }, "ESCC TX");
 }
 
 void EsccChannel::dma_out_rx()
@@ -463,7 +463,7 @@ void EsccChannel::dma_flush_tx()
         [this]() {
             this->timer_id_tx = 0;
             dma_ch[1]->end_pull_data();
-    });
+    }, "ESCC TX");
 }
 
 void EsccChannel::dma_flush_rx()
@@ -474,7 +474,7 @@ void EsccChannel::dma_flush_rx()
         [this]() {
             this->timer_id_rx = 0;
             dma_ch[1]->end_push_data();
-    });
+    }, "ESCC RX");
 }
 
 static const vector<string> CharIoBackends = {"null", "stdio", "socket"};
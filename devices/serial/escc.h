@@ -116,8 +116,8 @@ public:
     };
 
 private:
-    uint32_t timer_id_tx = 0;
-    uint32_t timer_id_rx = 0;
+    uint64_t timer_id_tx = 0;
+    uint64_t timer_id_rx = 0;
 
     void dma_start_tx();
     void dma_stop_tx();
@@ -121,7 +121,7 @@ void AwacsBase::dma_in_data() {
                 // re-enter the sequencer with the state specified in next_state
                 this->dma_in_timer_id = 0;
                 this->dma_in_data();
-        });
+        }, "AWACS DMA in");
     }
 }
 
@@ -89,7 +89,7 @@ void BurgundyCodec::snd_ctrl_write(uint32_t offset, uint32_t value, int size) {
                 [this]() {
                     this->first_valid  = 0;
                     this->byte_counter = (this->byte_counter + 1) & 3;
-            });
+            }, "Burgundy data");
         }
         break;
     default:
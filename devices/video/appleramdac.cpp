@@ -82,6 +82,8 @@ void AppleRamdac::iodev_write(uint32_t address, uint16_t value) {
             (this->clut_color[1] << 8) | this->clut_color[2];
             this->dac_addr++; // auto-increment CLUT address
             this->comp_index = 0;
+            if (this->cursor_update_cb)
+                this->cursor_update_cb();
         }
         break;
     case RamdacRegs::MULTI:
@@ -96,6 +98,8 @@ void AppleRamdac::iodev_write(uint32_t address, uint16_t value) {
 #else
             this->cursor_xpos = (value << 8) | (this->cursor_xpos & 0xff);
 #endif
+            if (this->cursor_update_cb)
+                this->cursor_update_cb();
             break;
         case RamdacRegs::CURSOR_POS_LO:
 #ifdef CURSOR_LO_DELAY // HACK: prevents artifacts in some cases, disabled by default
@@ -108,9 +112,13 @@ void AppleRamdac::iodev_write(uint32_t address, uint16_t value) {
             this->cursor_timer_id = TimerManager::get_instance()->add_oneshot_timer(
                 NS_PER_SEC / 60, [this]() {
                     this->cursor_xpos = (this->cursor_xpos & 0xff00) | (this->cursor_pos_lo & 0x00ff);
-                });
+                    if (this->cursor_update_cb)
+                        this->cursor_update_cb();
+                }, "RAMDAC cursor");
 #else
             this->cursor_xpos = (this->cursor_xpos & 0xff00) | (value & 0x00ff);
+            if (this->cursor_update_cb)
+                this->cursor_update_cb();
 #endif
             break;
         case RamdacRegs::MISC_CTRL:
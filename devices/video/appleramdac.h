@@ -89,6 +89,7 @@ enum RamdacRegs : uint8_t {
 typedef std::function<void(uint8_t index, uint8_t *colors)> GetClutEntryCallback;
 typedef std::function<void(uint8_t index, uint8_t *colors)> SetClutEntryCallback;
 typedef std::function<void(bool cursor_on)> CursorCtrlCallback;
+typedef std::function<void()> CursorUpdateCallback;
 
 class AppleRamdac : public HWComponent, public IobusDevice {
 public:
@@ -115,6 +116,7 @@ public:
     GetClutEntryCallback get_clut_entry_cb = nullptr;
     SetClutEntryCallback set_clut_entry_cb = nullptr;
     CursorCtrlCallback   cursor_ctrl_cb    = nullptr;
+    CursorUpdateCallback cursor_update_cb  = nullptr; // cursor moved or recolored
 
 protected:
     DacFlavour  flavour;
@@ -137,7 +139,7 @@ protected:
     uint32_t    fb_pitch        = 0;
 #ifdef CURSOR_LO_DELAY
     uint8_t     cursor_pos_lo   = 0;
-    uint32_t    cursor_timer_id = 0;
+    uint64_t    cursor_timer_id = 0;
 #endif
 };
 
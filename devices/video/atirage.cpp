@@ -23,12 +23,15 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <devices/common/hwcomponent.h>
 #include <devices/common/pci/pcidevice.h>
 #include <devices/deviceregistry.h>
+#include <devices/memctrl/memctrlbase.h>
 #include <devices/video/atirage.h>
 #include <devices/video/displayid.h>
 #include <endianswap.h>
 #include <loguru.hpp>
+#include <machines/machinebase.h>
 #include <memaccess.h>
 
+#include <algorithm>
 #include <map>
 
 /* Mach64 post dividers. */
@@ -162,13 +165,36 @@ void ATIRage::change_one_bar(uint32_t &aperture, uint32_t aperture_size,
     }
 }
 
+// Map both frame buffer apertures directly so that guest accesses
+// to VRAM don't need to go through read()/write().
+void ATIRage::map_vram()
+{
+    MemCtrlBase* mem_ctrl = dynamic_cast<MemCtrlBase*>(
+        gMachineObj->get_comp_by_type(HWCompType::MEM_CTRL));
+
+    this->begin_vram_remap(mem_ctrl);
+
+    if (this->aperture_base[0]) {
+        uint32_t fb_size = std::min(this->vram_size, (uint32_t)BE_FB_OFFSET);
+
+        this->map_vram_window(this->aperture_base[0], fb_size, this->vram_ptr.get());
+        this->map_vram_window(this->aperture_base[0] + BE_FB_OFFSET, fb_size,
+                              this->vram_ptr.get());
+    }
+
+    this->end_vram_remap();
+}
+
 void ATIRage::notify_bar_change(int bar_num)
 {
     switch (bar_num) {
     case 0:
-        change_one_bar(this->aperture_base[bar_num],
-                       this->aperture_size[bar_num] - this->vram_size,
-                       this->bars[bar_num] & ~15, bar_num);
+        if (this->aperture_base[bar_num] != (this->bars[bar_num] & ~15)) {
+            change_one_bar(this->aperture_base[bar_num],
+                           this->aperture_size[bar_num] - this->vram_size,
+                           this->bars[bar_num] & ~15, bar_num);
+            this->map_vram();
+        }
         break;
     case 2:
         change_one_bar(this->aperture_base[bar_num],
@@ -40,6 +40,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <devices/common/i2c/i2c.h>
 #include <devices/deviceregistry.h>
 #include <devices/ioctrl/macio.h>
+#include <devices/memctrl/memctrlbase.h>
 #include <devices/video/control.h>
 #include <endianswap.h>
 #include <loguru.hpp>
@@ -119,8 +120,10 @@ ControlVideo::ControlVideo()
     };
     this->radacal->set_clut_entry_cb = [this](uint8_t index, uint8_t *colors) {
         this->set_palette_color(index, colors[0], colors[1], colors[2], 0xFF);
+        this->draw_fb = true;
     };
     this->radacal->cursor_ctrl_cb = [this](bool cursor_on) {
+        this->draw_fb = true;
         if (cursor_on) {
             this->radacal->measure_hw_cursor(this->fb_ptr - 16);
             this->cursor_ovl_cb = [this](uint8_t *dst_buf, int dst_pitch) {
@@ -131,6 +134,9 @@ ControlVideo::ControlVideo()
             this->cursor_ovl_cb = nullptr;
         }
     };
+    this->radacal->cursor_update_cb = [this]() {
+        this->draw_fb = true;
+    };
 
     // attach IOBus Device #2 0xF301B000 ; register RaDACal with the I/O controller
     GrandCentral* gc_obj = dynamic_cast<GrandCentral*>(gMachineObj->get_comp_by_name("GrandCentral"));
@@ -157,10 +163,60 @@ void ControlVideo::notify_bar_change(int bar_num) {
     switch (bar_num) {
     case 0: change_one_bar(this->io_base  ,          4, this->bars[bar_num] & ~ 3, bar_num); break;
     case 1: change_one_bar(this->regs_base,     0x1000, this->bars[bar_num] & ~15, bar_num); break;
-    case 2: change_one_bar(this->vram_base, 0x04000000, this->bars[bar_num] & ~15, bar_num); break;
+    case 2:
+        if (this->vram_base != (this->bars[bar_num] & ~15)) {
+            change_one_bar(this->vram_base, 0x04000000, this->bars[bar_num] & ~15, bar_num);
+            this->map_vram();
+        }
+        break;
     }
 }
 
+// Map the parts of the VRAM aperture that behave like plain memory.
+// Bank mirrors with special write behavior are still handled by read()/write().
+void ControlVideo::map_vram() {
+    MemCtrlBase* mem_ctrl = dynamic_cast<MemCtrlBase*>(
+        gMachineObj->get_comp_by_type(HWCompType::MEM_CTRL));
+    uint8_t* vram = this->vram_ptr.get();
+
+    // all windows get mapped with a single page map rebuild and TLB flush
+    this->begin_vram_remap(mem_ctrl);
+
+    if (!this->vram_base) {
+        this->end_vram_remap();
+        return;
+    }
+
+    // the big-endian aperture repeats every 16MB
+    for (uint32_t base = this->vram_base + 0x800000; base < this->vram_base + 0x04000000;
+         base += 0x1000000) {
+        if (this->enables & VRAM_WIDE_MODE) {
+            if (this->vram_banks == 3 && this->vram_size >= 0x400000) {
+                this->map_vram_window(base,            0x400000, vram);
+                this->map_vram_window(base + 0x400000, 0x400000, vram);
+            }
+            continue;
+        }
+
+        switch (this->vram_banks) {
+        case 1: // standard bank and its two mirrors
+            for (uint32_t offset = 0; offset < 0x600000; offset += 0x200000)
+                this->map_vram_window(base + offset, 0x200000, vram);
+            break;
+        case 2: // optional bank
+            this->map_vram_window(base + 0x600000, 0x200000, vram);
+            break;
+        case 3: // standard bank, optional bank
+            this->map_vram_window(base + 0x400000, 0x200000, vram);
+            if (this->vram_size >= 0x400000)
+                this->map_vram_window(base + 0x600000, 0x200000, vram + 0x200000);
+            break;
+        }
+    }
+
+    this->end_vram_remap();
+}
+
 int ControlVideo::device_postinit() {
     this->int_ctrl = dynamic_cast<InterruptCtrl*>(
         gMachineObj->get_comp_by_type(HWCompType::INT_CTRL));
@@ -361,6 +417,7 @@ uint32_t ControlVideo::read(uint32_t rgn_start, uint32_t offset, int size)
 void ControlVideo::write(uint32_t rgn_start, uint32_t offset, uint32_t value, int size)
 {
     if (rgn_start == this->vram_base) {
+        this->draw_fb = true; // not covered by the VRAM dirty bits
         if (offset & 0x800000) {
             if (this->enables & VRAM_WIDE_MODE) {
                 // Note: we ignore access to 4MB range at 0xC00000 because it is undefined for VRAM_WIDE_MODE.
@@ -520,18 +577,22 @@ void ControlVideo::write(uint32_t rgn_start, uint32_t offset, uint32_t value, in
                 this->cur_mon_id = this->display_id->read_monitor_sense(levels, dirs);
             }
             break;
-        case ControlRegs::MISC_ENABLES:
-            if ((this->enables ^ value) & BLANK_DISABLE) {
-                if (value & BLANK_DISABLE)
-                    this->blank_on = false;
-                else {
-                    this->blank_on = true;
-                    this->blank_display();
+        case ControlRegs::MISC_ENABLES: {
+                uint32_t changed = this->enables ^ value;
+                if (changed & BLANK_DISABLE) {
+                    if (value & BLANK_DISABLE)
+                        this->blank_on = false;
+                    else {
+                        this->blank_on = true;
+                        this->blank_display();
+                    }
                 }
+                this->enables = value & 0xFFF;
+                if (changed & VRAM_WIDE_MODE)
+                    this->map_vram(); // bank layout changed
+                if (this->enables & FB_ENDIAN_LITTLE)
+                    LOG_F(ERROR, "%s: little-endian framebuffer is not implemented yet", this->name.c_str());
             }
-            this->enables = value & 0xFFF;
-            if (this->enables & FB_ENDIAN_LITTLE)
-                LOG_F(ERROR, "%s: little-endian framebuffer is not implemented yet", this->name.c_str());
             break;
         case ControlRegs::GSC_DIVIDE:
             this->clock_divider = value & 3;
@@ -586,6 +647,7 @@ void ControlVideo::enable_display()
     // set framebuffer parameters
     this->fb_ptr   = &this->vram_ptr[this->fb_base];
     this->fb_pitch = this->row_words;
+    this->draw_fb  = true;
     if (~this->enables & SCAN_CONTROL) {
         this->fb_pitch >>= 1;
     }
@@ -128,6 +128,7 @@ protected:
     void change_one_bar(uint32_t &aperture, uint32_t aperture_size, uint32_t aperture_new,
                         int bar_num);
     void notify_bar_change(int bar_num);
+    void map_vram();
 
     void enable_display();
     void disable_display();
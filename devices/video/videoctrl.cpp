@@ -22,10 +22,13 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 /** @file Video Controller base class implementation. */
 
 #include <core/timermanager.h>
+#include <cpu/ppc/ppcmmu.h>
 #include <devices/common/hwinterrupt.h>
+#include <devices/memctrl/memctrlbase.h>
 #include <devices/video/videoctrl.h>
 #include <memaccess.h>
 
+#include <algorithm>
 #include <cinttypes>
 
 VideoCtrlBase::VideoCtrlBase(int width, int height)
@@ -65,6 +68,7 @@ void VideoCtrlBase::update_screen()
 {
     if (this->blank_on) {
         this->display.blank();
+        this->draw_fb = true; // redraw once the display gets unblanked
         return;
     }
 
@@ -74,7 +78,10 @@ void VideoCtrlBase::update_screen()
         this->get_cursor_position(cursor_x, cursor_y);
     }
 
-    if (draw_fb) {
+    // always check so that the dirty bits get cleared
+    bool fb_dirty = this->test_and_clear_fb_dirty();
+
+    if (draw_fb || fb_dirty) {
         if (this->cursor_dirty) {
             this->setup_hw_cursor();
             this->cursor_dirty = false;
@@ -82,7 +89,61 @@ void VideoCtrlBase::update_screen()
         this->display.update(
             this->convert_fb_cb, this->cursor_ovl_cb,
             this->cursor_on, cursor_x, cursor_y);
+
+        // writes through VRAM windows are caught by the dirty bits,
+        // everything else changing the picture has to set draw_fb again
+        if (!this->vram_windows.empty())
+            this->draw_fb = false;
+    }
+}
+
+void VideoCtrlBase::begin_vram_remap(MemCtrlBase* mem_ctrl)
+{
+    mem_ctrl->begin_map_update();
+
+    for (auto& wnd : this->vram_windows)
+        this->vram_mem_ctrl->remove_vram_region(wnd.start_addr, wnd.size);
+    this->vram_unmapped = !this->vram_windows.empty();
+    this->vram_windows.clear();
+
+    this->vram_mem_ctrl = mem_ctrl;
+}
+
+void VideoCtrlBase::map_vram_window(uint32_t start_addr, uint32_t size, uint8_t* host_ptr)
+{
+    if (this->vram_mem_ctrl->add_vram_region(start_addr, size, host_ptr))
+        this->vram_windows.push_back({start_addr, size, host_ptr});
+}
+
+void VideoCtrlBase::end_vram_remap()
+{
+    this->vram_mem_ctrl->end_map_update();
+
+    // accesses cached in the TLBs may now go to VRAM or MMIO instead
+    if (this->vram_unmapped || !this->vram_windows.empty())
+        tlb_flush_device_entries();
+}
+
+// Check if the visible part of the frame buffer has been written to
+// through any of the VRAM windows since the last call.
+bool VideoCtrlBase::test_and_clear_fb_dirty()
+{
+    bool dirty = false;
+
+    if (!this->fb_ptr)
+        return false;
+
+    uint8_t* fb_end = this->fb_ptr + this->fb_pitch * this->active_height;
+
+    for (auto& wnd : this->vram_windows) {
+        uint8_t* start = std::max(this->fb_ptr, wnd.host_ptr);
+        uint8_t* end   = std::min(fb_end, wnd.host_ptr + wnd.size);
+        if (start < end)
+            dirty |= vram_test_and_clear_dirty(
+                wnd.start_addr + (uint32_t)(start - wnd.host_ptr), (uint32_t)(end - start));
     }
+
+    return dirty;
 }
 
 void VideoCtrlBase::start_refresh_task() {
@@ -95,7 +156,7 @@ void VideoCtrlBase::start_refresh_task() {
             // assert VBL interrupt
             this->vbl_cb(1);
             this->update_screen();
-        }
+        }, "VBL start"
     );
 
     if (vert_blank == 0) {
@@ -110,7 +171,7 @@ void VideoCtrlBase::start_refresh_task() {
         [this]() {
             // deassert VBL interrupt
             this->vbl_cb(0);
-        }
+        }, "VBL end"
     );
 }
 
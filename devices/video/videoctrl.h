@@ -29,7 +29,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <cinttypes>
 #include <functional>
+#include <vector>
 
+class MemCtrlBase;
 class WindowEvent;
 
 class VideoCtrlBase {
@@ -71,6 +73,15 @@ public:
     virtual void convert_frame_32bpp_BE(uint8_t *dst_buf, int dst_pitch);
 
 protected:
+    // Direct mapping of VRAM into the guest physical address space.
+    // Guest writes to mapped VRAM trigger a screen update on their own.
+    // begin_vram_remap() drops the current windows, new ones are added with
+    // map_vram_window() and take effect at end_vram_remap().
+    void begin_vram_remap(MemCtrlBase* mem_ctrl);
+    void map_vram_window(uint32_t start_addr, uint32_t size, uint8_t* host_ptr);
+    void end_vram_remap();
+    bool test_and_clear_fb_dirty();
+
     // CRT controller parameters
     bool        crtc_on = false;
     bool        blank_on = true;
@@ -93,8 +104,8 @@ protected:
     // Framebuffer parameters
     uint8_t*    fb_ptr = nullptr;
     int         fb_pitch = 0;
-    uint32_t    refresh_task_id = 0;
-    uint32_t    vbl_end_task_id = 0;
+    uint64_t    refresh_task_id = 0;
+    uint64_t    vbl_end_task_id = 0;
 
     // interrupt suff
     InterruptCtrl* int_ctrl = nullptr;
@@ -109,6 +120,16 @@ protected:
 
 private:
     Display display;
+
+    typedef struct VramWindow {
+        uint32_t    start_addr;
+        uint32_t    size;
+        uint8_t*    host_ptr;
+    } VramWindow;
+
+    MemCtrlBase*            vram_mem_ctrl = nullptr;
+    std::vector<VramWindow> vram_windows;
+    bool                    vram_unmapped = false; // windows dropped by begin_vram_remap()
 };
 
 #endif // VIDEO_CTRL_H
@@ -25,7 +25,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <core/hostevents.h>
 #include <core/timermanager.h>
 #include <cpu/ppc/ppcemu.h>
+#include <cpu/ppc/ppcidle.h>
+#include <cpu/ppc/ppcjit.h>
 #include <debugger/debugger.h>
+#include <devices/memctrl/fastmem.h>
 #include <machines/machinebase.h>
 #include <machines/machinefactory.h>
 #include <utils/profiler.h>
@@ -72,7 +75,7 @@ int main(int argc, char** argv) {
     app.allow_windows_style_options(); /* we want Windows-style options */
     app.allow_extras();
 
-    bool   realtime_enabled, debugger_enabled;
+    bool   realtime_enabled, debugger_enabled, recompiler_enabled, no_idle_skip, no_fastmem;
     string machine_str;
     string bootrom_path("bootrom.bin");
 
@@ -82,9 +85,22 @@ int main(int argc, char** argv) {
     app.add_flag("-d,--debugger", debugger_enabled,
         "Enter the built-in debugger");
 
+    app.add_flag("-j,--jit", recompiler_enabled,
+        "Translate hot guest code into host code (x86-64 only)");
+
+    app.add_flag("--no-idle-skip", no_idle_skip,
+        "Interpret guest idle loops instead of skipping ahead in time");
+
+    app.add_flag("--no-fastmem", no_fastmem,
+        "Don't map guest physical memory into a host address range");
+
     app.add_option("-b,--bootrom", bootrom_path, "Specifies BootROM path")
         ->check(CLI::ExistingFile);
 
+    uint64_t timer_slack_ns = TIMER_SLACK_NS;
+    app.add_option("--timer-slack-ns", timer_slack_ns,
+        "Process timers expiring within this many nanoseconds of each other together");
+
     uint32_t profiling_interval_ms = 0;
 #ifdef CPU_PROFILING
     app.add_option("--profiling-interval-ms", profiling_interval_ms,
@@ -119,14 +135,23 @@ int main(int argc, char** argv) {
         if (realtime_enabled)
             cout << "Both realtime and debugger enabled! Using debugger" << endl;
         execution_mode = 1;
+    } else {
+        g_realtime = realtime_enabled;
+        if (recompiler_enabled)
+            execution_mode = jit;
     }
 
+    idle_skip_enabled = !no_idle_skip;
+    fastmem_enabled   = !no_fastmem;
+
+    TimerManager::get_instance()->set_timer_slack(timer_slack_ns);
+
     /* initialize logging */
     loguru::g_preamble_date    = false;
     loguru::g_preamble_time    = false;
     loguru::g_preamble_thread  = false;
 
-    if (!execution_mode) {
+    if (execution_mode == interpreter || execution_mode == jit) {
         loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
         loguru::init(argc, argv);
         loguru::add_file("dingusppc.log", loguru::Append, 0);
@@ -215,16 +240,16 @@ void run_machine(std::string machine_str, std::string bootrom_path, uint32_t exe
 
     // set up system wide event polling using
     // default Macintosh polling rate of 11 ms
-    uint32_t event_timer = TimerManager::get_instance()->add_cyclic_timer(MSECS_TO_NSECS(11), [] {
+    uint64_t event_timer = TimerManager::get_instance()->add_cyclic_timer(MSECS_TO_NSECS(11), [] {
         EventManager::get_instance()->poll_events();
-    });
+    }, "poll_events");
 
 #ifdef CPU_PROFILING
-    uint32_t profiling_timer;
+    uint64_t profiling_timer;
     if (profiling_interval_ms > 0) {
         profiling_timer = TimerManager::get_instance()->add_cyclic_timer(MSECS_TO_NSECS(profiling_interval_ms), [] {
             gProfilerObj->print_profile("PPC_CPU");
-        });
+        }, "CPU profiling");
     }
 #endif
 
@@ -237,6 +262,12 @@ void run_machine(std::string machine_str, std::string bootrom_path, uint32_t exe
         power_off_reason = po_enter_debugger;
         enter_debugger();
         break;
+    case jit:
+        if (!ppc_jit_init())
+            LOG_F(WARNING, "JIT unavailable, falling back to the interpreter");
+        power_off_reason = po_starting_up;
+        enter_debugger();
+        break;
     default:
         LOG_F(ERROR, "Invalid EXECUTION MODE");
         return;